@@ -0,0 +1,352 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+// Measures nanoseconds per object per update of the core kernels, without the engine:
+// - Single: one service data struct per object, the way the Blueprint library is used
+// - Batched: structure of arrays evaluated one object at a time
+// - SIMD: structure of arrays evaluated four objects at a time
+// - Parallel: SIMD split into fixed-size chunks over all hardware threads, the way FMotionIntensityBatch does it
+// - Velocity: structure of arrays evaluated from known velocities instead of transforms
+// Afterwards the batched path is measured once per derivative filter, and the precision of the single precision batch state
+// is checked far from the world origin.
+
+#include "MotionIntensityCore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace MotionIntensityCore;
+
+namespace
+{
+	constexpr float DeltaTime = 1.0f / 60.0f;
+	constexpr int ChunkSize = 256;
+	constexpr int MinParallelSize = 2048;
+	constexpr long long TargetUpdatesPerPath = 4000000;
+
+	// Inputs of one frame, every object moves along its own smooth path
+	struct FFrame
+	{
+		std::vector<FVector3> Locations;
+		std::vector<FQuat4> Rotations;
+		std::vector<FVector3> LinearVelocities;
+		std::vector<FVector3> AngularVelocities;
+
+		void Generate(const int Number, const int FrameIndex, const double Offset = 0.0)
+		{
+			Locations.resize(Number);
+			Rotations.resize(Number);
+			LinearVelocities.resize(Number);
+			AngularVelocities.resize(Number);
+			const double Time = FrameIndex * static_cast<double>(DeltaTime);
+			for (int Index = 0; Index < Number; ++Index)
+			{
+				const double Phase = Index * 0.61803398875;
+				const double Speed = 1.0 + (Index % 7) * 0.5;
+				// Objects spread over a kilometer centered on the given offset along X
+				Locations[Index] = {
+					Offset + 1000.0 * (Index % 100 - 50) + 300.0 * std::sin(Speed * Time + Phase),
+					200.0 * std::cos(0.5 * Speed * Time + Phase),
+					50.0 * std::sin(3.0 * Time + Phase)
+				};
+
+				const double HalfAngle = 0.5 * std::sin(Speed * Time + Phase);
+				const double Length = std::sqrt(1.0 + 4.0 + 9.0);
+				const double Sin = std::sin(HalfAngle) / Length;
+				Rotations[Index] = {Sin * 1.0, Sin * 2.0, Sin * 3.0, std::cos(HalfAngle)};
+
+				// Derivatives of the above
+				LinearVelocities[Index] = {
+					300.0 * Speed * std::cos(Speed * Time + Phase),
+					-100.0 * Speed * std::sin(0.5 * Speed * Time + Phase),
+					150.0 * std::cos(3.0 * Time + Phase)
+				};
+				const double AngularSpeed = Speed * std::cos(Speed * Time + Phase) / Length;
+				AngularVelocities[Index] = {AngularSpeed * 1.0, AngularSpeed * 2.0, AngularSpeed * 3.0};
+			}
+		}
+	};
+
+	// Structure of arrays state, owned by the benchmark and viewed by the core. Like FMotionIntensityBatch, filter states
+	// and fixed step state are only allocated when the config needs them.
+	struct FBatchState
+	{
+		FVector3 Origin{};
+		std::unique_ptr<bool[]> SetPreviousTransformToCurrent;
+		std::vector<FFloatVector3> PreviousLocations;
+		std::vector<FFloatQuat4> PreviousRotations;
+		std::vector<float> PreviousLinearVelocities;
+		std::vector<float> PreviousLinearAccelerations;
+		std::vector<float> PreviousAngularVelocities;
+		std::vector<float> PreviousAngularAccelerations;
+		std::vector<FFilterState> LinearVelocityFilterStates;
+		std::vector<FFilterState> LinearAccelerationFilterStates;
+		std::vector<FFilterState> AngularVelocityFilterStates;
+		std::vector<FFilterState> AngularAccelerationFilterStates;
+		std::vector<float> TimeAccumulators;
+		std::vector<FPackedMotionData> FixedStepMotionData;
+
+		FBatchState(const int Number, const FConfig& Config)
+			: SetPreviousTransformToCurrent(new bool[Number])
+			, PreviousLocations(Number)
+			, PreviousRotations(Number)
+			, PreviousLinearVelocities(Number)
+			, PreviousLinearAccelerations(Number)
+			, PreviousAngularVelocities(Number)
+			, PreviousAngularAccelerations(Number)
+		{
+			std::fill_n(SetPreviousTransformToCurrent.get(), Number, true);
+
+			if (DispatchFilter(Config, [](auto Filter) { return decltype(Filter)::bHasState; }))
+			{
+				LinearVelocityFilterStates.resize(Number);
+				LinearAccelerationFilterStates.resize(Number);
+				AngularVelocityFilterStates.resize(Number);
+				AngularAccelerationFilterStates.resize(Number);
+			}
+			if (Config.bUseFixedTimeStep)
+			{
+				TimeAccumulators.resize(Number);
+				FixedStepMotionData.resize(Number);
+			}
+		}
+
+		// Bytes of state per object
+		int GetEntrySize() const
+		{
+			const bool bHasFilterStates = !LinearVelocityFilterStates.empty();
+			const bool bHasFixedStepState = !TimeAccumulators.empty();
+			return sizeof(bool) + sizeof(FFloatVector3) + sizeof(FFloatQuat4) + 4 * sizeof(float)
+				+ (bHasFilterStates ? 4 * sizeof(FFilterState) : 0)
+				+ (bHasFixedStepState ? sizeof(float) + sizeof(FPackedMotionData) : 0);
+		}
+
+		TBatchView<FVector3, FQuat4> GetView()
+		{
+			TBatchView<FVector3, FQuat4> View;
+			View.Origin = Origin;
+			View.SetPreviousTransformToCurrent = SetPreviousTransformToCurrent.get();
+			View.PreviousLocations = PreviousLocations.data();
+			View.PreviousRotations = PreviousRotations.data();
+			View.PreviousLinearVelocities = PreviousLinearVelocities.data();
+			View.PreviousLinearAccelerations = PreviousLinearAccelerations.data();
+			View.PreviousAngularVelocities = PreviousAngularVelocities.data();
+			View.PreviousAngularAccelerations = PreviousAngularAccelerations.data();
+			View.LinearVelocityFilterStates = LinearVelocityFilterStates.data();
+			View.LinearAccelerationFilterStates = LinearAccelerationFilterStates.data();
+			View.AngularVelocityFilterStates = AngularVelocityFilterStates.data();
+			View.AngularAccelerationFilterStates = AngularAccelerationFilterStates.data();
+			View.TimeAccumulators = TimeAccumulators.data();
+			View.FixedStepMotionData = FixedStepMotionData.data();
+			return View;
+		}
+	};
+
+	void EvaluateBatch(FBatchState& State,
+	                   const FFrame& Frame,
+	                   const FConfig& Config,
+	                   const FCoefficients& Coefficients,
+	                   const bool bVectorized,
+	                   const bool bParallel,
+	                   float* OutMotionIntensities)
+	{
+		const int Number = static_cast<int>(Frame.Locations.size());
+		const TBatchView<FVector3, FQuat4> View = State.GetView();
+		const FCompiledCoefficients CompiledCoefficients = CompileCoefficients(Coefficients);
+		auto Output = [&](const int Index, const FPackedMotionData& MotionData)
+		{
+			OutMotionIntensities[Index] = GetMotionIntensityFromMotionData(MotionData, CompiledCoefficients);
+		};
+
+		if (!bParallel || Number < MinParallelSize)
+		{
+			EvaluateRange(View, 0, Number, Frame.Locations.data(), Frame.Rotations.data(), DeltaTime, Config, bVectorized, Output);
+			return;
+		}
+
+		const int NumChunks = (Number + ChunkSize - 1) / ChunkSize;
+		const int NumThreads = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), NumChunks));
+		std::atomic<int> NextChunk{0};
+		auto Worker = [&]()
+		{
+			for (int Chunk = NextChunk++; Chunk < NumChunks; Chunk = NextChunk++)
+			{
+				const int Begin = Chunk * ChunkSize;
+				const int End = std::min(Begin + ChunkSize, Number);
+				EvaluateRange(View, Begin, End, Frame.Locations.data(), Frame.Rotations.data(), DeltaTime, Config, bVectorized, Output);
+			}
+		};
+
+		std::vector<std::thread> Threads;
+		for (int Thread = 1; Thread < NumThreads; ++Thread)
+		{
+			Threads.emplace_back(Worker);
+		}
+		Worker();
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+	}
+
+	enum class EPath
+	{
+		Single,
+		Batched,
+		Simd,
+		Parallel,
+		Velocity
+	};
+
+	// Returns nanoseconds per object per update, input generation is not timed
+	double Measure(const EPath Path, const int Number, const int NumFrames, const FConfig& Config, const FCoefficients& Coefficients)
+	{
+		FFrame Frame;
+		std::vector<float> MotionIntensities(Number);
+		std::vector<FServiceData> ServiceData(Path == EPath::Single ? Number : 0);
+		FBatchState State(Path == EPath::Single ? 0 : Number, Config);
+
+		std::chrono::steady_clock::duration Elapsed{};
+		float Checksum = 0.0f;
+
+		for (int FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			Frame.Generate(Number, FrameIndex);
+
+			const auto Start = std::chrono::steady_clock::now();
+			if (Path == EPath::Single)
+			{
+				for (int Index = 0; Index < Number; ++Index)
+				{
+					const FMotionData MotionData = CalculateMotionData<FMotionData>(Frame.Locations[Index], Frame.Rotations[Index], DeltaTime, Config, ServiceData[Index]);
+					MotionIntensities[Index] = GetMotionIntensityFromMotionData(MotionData, Coefficients);
+				}
+			}
+			else if (Path == EPath::Velocity)
+			{
+				const FCompiledCoefficients CompiledCoefficients = CompileCoefficients(Coefficients);
+				auto Output = [&](const int Index, const FPackedMotionData& MotionData)
+				{
+					MotionIntensities[Index] = GetMotionIntensityFromMotionData(MotionData, CompiledCoefficients);
+				};
+				EvaluateRangeFromVelocity(State.GetView(), 0, Number, Frame.LinearVelocities.data(), Frame.AngularVelocities.data(), DeltaTime, Config, Output);
+			}
+			else
+			{
+				EvaluateBatch(State, Frame, Config, Coefficients, Path != EPath::Batched, Path == EPath::Parallel, MotionIntensities.data());
+			}
+			Elapsed += std::chrono::steady_clock::now() - Start;
+
+			Checksum += MotionIntensities[FrameIndex % Number];
+		}
+
+		// Keeps the optimizer from throwing the work away
+		if (Checksum < 0.0f)
+		{
+			std::printf("%f\n", Checksum);
+		}
+
+		return std::chrono::duration<double, std::nano>(Elapsed).count() / (static_cast<double>(Number) * NumFrames);
+	}
+
+	// Largest difference between scalar and SIMD motion intensity over a few seconds of motion
+	float MeasureSimdDeviation(const int Number, const FConfig& Config, const FCoefficients& Coefficients)
+	{
+		FFrame Frame;
+		FBatchState ScalarState(Number, Config);
+		FBatchState SimdState(Number, Config);
+		std::vector<float> ScalarIntensities(Number);
+		std::vector<float> SimdIntensities(Number);
+
+		float MaxDeviation = 0.0f;
+		for (int FrameIndex = 0; FrameIndex < 240; ++FrameIndex)
+		{
+			Frame.Generate(Number, FrameIndex);
+			EvaluateBatch(ScalarState, Frame, Config, Coefficients, false, false, ScalarIntensities.data());
+			EvaluateBatch(SimdState, Frame, Config, Coefficients, true, false, SimdIntensities.data());
+			for (int Index = 0; Index < Number; ++Index)
+			{
+				MaxDeviation = std::max(MaxDeviation, std::abs(ScalarIntensities[Index] - SimdIntensities[Index]));
+			}
+		}
+		return MaxDeviation;
+	}
+
+	// Largest difference between the double precision single path and the batch with the given origin, over a few seconds
+	// of motion of objects around the given offset
+	float MeasureOriginDeviation(const int Number,
+	                             const double Offset,
+	                             const FVector3& Origin,
+	                             const FConfig& Config,
+	                             const FCoefficients& Coefficients)
+	{
+		FFrame Frame;
+		std::vector<FServiceData> ServiceData(Number);
+		FBatchState State(Number, Config);
+		State.Origin = Origin;
+		std::vector<float> BatchIntensities(Number);
+
+		float MaxDeviation = 0.0f;
+		for (int FrameIndex = 0; FrameIndex < 240; ++FrameIndex)
+		{
+			Frame.Generate(Number, FrameIndex, Offset);
+			EvaluateBatch(State, Frame, Config, Coefficients, true, false, BatchIntensities.data());
+			for (int Index = 0; Index < Number; ++Index)
+			{
+				const FMotionData MotionData = CalculateMotionData<FMotionData>(Frame.Locations[Index], Frame.Rotations[Index], DeltaTime, Config, ServiceData[Index]);
+				const float MotionIntensity = GetMotionIntensityFromMotionData(MotionData, Coefficients);
+				MaxDeviation = std::max(MaxDeviation, std::abs(MotionIntensity - BatchIntensities[Index]));
+			}
+		}
+		return MaxDeviation;
+	}
+}
+
+int main()
+{
+	const FConfig Config;
+	const FCoefficients Coefficients;
+	const int ObjectCounts[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+	std::printf("Motion intensity core, ns per object per update, SIMD %s, %u hardware threads, %d bytes of batch state per object\n",
+	            MOTIONINTENSITY_CORE_SSE ? "SSE2" : "scalar fallback",
+	            std::thread::hardware_concurrency(),
+	            FBatchState(1, Config).GetEntrySize());
+	std::printf("%10s %12s %12s %12s %12s %12s\n", "Objects", "Single", "Batched", "SIMD", "Parallel", "Velocity");
+
+	for (const int Number : ObjectCounts)
+	{
+		const int NumFrames = static_cast<int>(std::max<long long>(8, TargetUpdatesPerPath / Number));
+		std::printf("%10d %12.2f %12.2f %12.2f %12.2f %12.2f\n",
+		            Number,
+		            Measure(EPath::Single, Number, NumFrames, Config, Coefficients),
+		            Measure(EPath::Batched, Number, NumFrames, Config, Coefficients),
+		            Measure(EPath::Simd, Number, NumFrames, Config, Coefficients),
+		            Measure(EPath::Parallel, Number, NumFrames, Config, Coefficients),
+		            Measure(EPath::Velocity, Number, NumFrames, Config, Coefficients));
+	}
+
+	std::printf("Max SIMD deviation from scalar motion intensity: %g\n", MeasureSimdDeviation(1024, Config, Coefficients));
+
+	const double FarOffset = 2000000.0;
+	std::printf("Max deviation from double precision 20 km from the world origin: batch origin at world origin %g, at the objects %g\n",
+	            MeasureOriginDeviation(1024, FarOffset, FVector3{}, Config, Coefficients),
+	            MeasureOriginDeviation(1024, FarOffset, FVector3{FarOffset, 0.0, 0.0}, Config, Coefficients));
+
+	const char* FilterNames[] = {"Exponential", "OneEuro", "Spring", "Biquad"};
+	const int FilterObjects = 10000;
+	std::printf("Batched ns per object per update by filter, %d objects:", FilterObjects);
+	for (int Filter = 0; Filter < 4; ++Filter)
+	{
+		FConfig FilterConfig = Config;
+		FilterConfig.Filter = static_cast<EFilter>(Filter);
+		std::printf(" %s %.2f", FilterNames[Filter], Measure(EPath::Batched, FilterObjects, TargetUpdatesPerPath / FilterObjects, FilterConfig, Coefficients));
+	}
+	std::printf("\n");
+	return 0;
+}
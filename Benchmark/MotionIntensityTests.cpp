@@ -0,0 +1,234 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+// Checks of the engine-independent core that don't need the engine, run with ctest:
+// - Indices: entries evaluated every few frames match entries evaluated every frame for motion at a constant velocity
+// - Settle: service data settled at replicated values continues from them without a transient
+
+#include "MotionIntensityCore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace MotionIntensityCore;
+
+namespace
+{
+	constexpr float DeltaTime = 1.0f / 60.0f;
+
+	int NumFailures = 0;
+
+	void Expect(const bool bCondition, const char* Name, const char* Message, const double Value)
+	{
+		if (!bCondition)
+		{
+			std::printf("FAILED %s: %s (%g)\n", Name, Message, Value);
+			++NumFailures;
+		}
+	}
+
+	// Structure of arrays state, owned by the test and viewed by the core
+	struct FBatchState
+	{
+		std::unique_ptr<bool[]> SetPreviousTransformToCurrent;
+		std::vector<FFloatVector3> PreviousLocations;
+		std::vector<FFloatQuat4> PreviousRotations;
+		std::vector<float> PreviousLinearVelocities;
+		std::vector<float> PreviousLinearAccelerations;
+		std::vector<float> PreviousAngularVelocities;
+		std::vector<float> PreviousAngularAccelerations;
+		std::vector<FFilterState> LinearVelocityFilterStates;
+		std::vector<FFilterState> LinearAccelerationFilterStates;
+		std::vector<FFilterState> AngularVelocityFilterStates;
+		std::vector<FFilterState> AngularAccelerationFilterStates;
+		std::vector<float> TimeAccumulators;
+		std::vector<FPackedMotionData> FixedStepMotionData;
+		std::vector<FFloatVector3> PreviousInputLocations;
+		std::vector<FFloatQuat4> PreviousInputRotations;
+
+		explicit FBatchState(const int Number)
+			: SetPreviousTransformToCurrent(new bool[Number])
+			, PreviousLocations(Number)
+			, PreviousRotations(Number)
+			, PreviousLinearVelocities(Number)
+			, PreviousLinearAccelerations(Number)
+			, PreviousAngularVelocities(Number)
+			, PreviousAngularAccelerations(Number)
+			, LinearVelocityFilterStates(Number)
+			, LinearAccelerationFilterStates(Number)
+			, AngularVelocityFilterStates(Number)
+			, AngularAccelerationFilterStates(Number)
+			, TimeAccumulators(Number)
+			, FixedStepMotionData(Number)
+			, PreviousInputLocations(Number)
+			, PreviousInputRotations(Number)
+		{
+			std::fill_n(SetPreviousTransformToCurrent.get(), Number, true);
+		}
+
+		TBatchView<FVector3, FQuat4> GetView()
+		{
+			TBatchView<FVector3, FQuat4> View;
+			View.SetPreviousTransformToCurrent = SetPreviousTransformToCurrent.get();
+			View.PreviousLocations = PreviousLocations.data();
+			View.PreviousRotations = PreviousRotations.data();
+			View.PreviousLinearVelocities = PreviousLinearVelocities.data();
+			View.PreviousLinearAccelerations = PreviousLinearAccelerations.data();
+			View.PreviousAngularVelocities = PreviousAngularVelocities.data();
+			View.PreviousAngularAccelerations = PreviousAngularAccelerations.data();
+			View.LinearVelocityFilterStates = LinearVelocityFilterStates.data();
+			View.LinearAccelerationFilterStates = LinearAccelerationFilterStates.data();
+			View.AngularVelocityFilterStates = AngularVelocityFilterStates.data();
+			View.AngularAccelerationFilterStates = AngularAccelerationFilterStates.data();
+			View.TimeAccumulators = TimeAccumulators.data();
+			View.FixedStepMotionData = FixedStepMotionData.data();
+			View.PreviousInputLocations = PreviousInputLocations.data();
+			View.PreviousInputRotations = PreviousInputRotations.data();
+			return View;
+		}
+	};
+
+	float GetMaxDifference(const FPackedMotionData& A, const FPackedMotionData& B)
+	{
+		return std::max({
+			std::abs(A.LinearVelocityNormalized - B.LinearVelocityNormalized),
+			std::abs(A.LinearAccelerationNormalized - B.LinearAccelerationNormalized),
+			std::abs(A.LinearJerkNormalized - B.LinearJerkNormalized),
+			std::abs(A.AngularVelocityNormalized - B.AngularVelocityNormalized),
+			std::abs(A.AngularAccelerationNormalized - B.AngularAccelerationNormalized),
+			std::abs(A.AngularJerkNormalized - B.AngularJerkNormalized)
+		});
+	}
+
+	// Entry 0 is evaluated every frame, the others every 2, 4 and 8 frames over the same motion at a constant velocity
+	void TestIndicesAtConstantVelocity(const EFilter Filter, const char* Name)
+	{
+		constexpr int Intervals[] = {1, 2, 4, 8};
+		constexpr int Number = 4;
+		constexpr int NumFrames = 240;
+
+		FConfig Config;
+		Config.Filter = Filter;
+
+		// Without the state the config doesn't need, like FMotionIntensityBatch
+		FBatchState State(Number);
+		TBatchView<FVector3, FQuat4> View = State.GetView();
+		if (Filter == EFilter::Exponential)
+		{
+			View.LinearVelocityFilterStates = nullptr;
+			View.LinearAccelerationFilterStates = nullptr;
+			View.AngularVelocityFilterStates = nullptr;
+			View.AngularAccelerationFilterStates = nullptr;
+		}
+		View.TimeAccumulators = nullptr;
+		View.FixedStepMotionData = nullptr;
+		std::vector<FPackedMotionData> MotionData(Number);
+		auto Output = [&MotionData](const int Index, const FPackedMotionData& EntryMotionData)
+		{
+			MotionData[Index] = EntryMotionData;
+		};
+
+		float MaxDifference = 0.0f;
+		for (int Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			// 500 cm/s along a diagonal and a quarter turn per second around a tilted axis
+			const double Time = Frame * static_cast<double>(DeltaTime);
+			const double Distance = 500.0 * Time / std::sqrt(3.0);
+			const FVector3 Location = {100.0 + Distance, -200.0 + Distance, Distance};
+			const double HalfAngle = 0.25 * Pi * Time;
+			const double Sin = std::sin(HalfAngle) / std::sqrt(1.0 + 4.0 + 9.0);
+			const FQuat4 Rotation = {Sin * 1.0, Sin * 2.0, Sin * 3.0, std::cos(HalfAngle)};
+
+			const std::vector<FVector3> Locations(Number, Location);
+			const std::vector<FQuat4> Rotations(Number, Rotation);
+			std::vector<int> Indices;
+			std::vector<float> DeltaTimes(Number);
+			std::vector<int> Frames(Number);
+			for (int Index = 0; Index < Number; ++Index)
+			{
+				// Every entry takes its first update on the first frame
+				if (Frame % Intervals[Index] == 0)
+				{
+					Indices.push_back(Index);
+					Frames[Index] = Frame == 0 ? 1 : Intervals[Index];
+					DeltaTimes[Index] = Frames[Index] * DeltaTime;
+				}
+			}
+
+			EvaluateIndices(View, Indices.data(), static_cast<int>(Indices.size()), Locations.data(), Rotations.data(), DeltaTimes.data(), Frames.data(), Config, Output);
+
+			if (Frame % Intervals[Number - 1] == 0)
+			{
+				for (int Index = 1; Index < Number; ++Index)
+				{
+					MaxDifference = std::max(MaxDifference, GetMaxDifference(MotionData[0], MotionData[Index]));
+				}
+			}
+		}
+
+		Expect(std::abs(MotionData[0].LinearVelocityNormalized - 0.5f) < 1.e-3f, Name, "every frame velocity isn't 0.5", MotionData[0].LinearVelocityNormalized);
+		Expect(MaxDifference < 1.e-3f, Name, "skipped frames differ from every frame", MaxDifference);
+	}
+
+	// Runs service data through changing motion, settles it at a constant velocity like replication does, and checks that
+	// holding that velocity afterwards keeps acceleration and jerk at zero
+	void TestSettleFilters(const EFilter Filter, const char* Name)
+	{
+		FConfig Config;
+		Config.Filter = Filter;
+		Config.bCalculateAngularMotion = false;
+
+		FServiceData ServiceData;
+		FVector3 Location;
+		for (int Frame = 0; Frame < 60; ++Frame)
+		{
+			Location.X += 20.0 * std::sin(0.3 * Frame);
+			CalculateMotionData<FMotionData>(Location, FQuat4(), DeltaTime, Config, ServiceData);
+		}
+
+		// 600 cm/s, with the smoothed location trailing by its steady lag so velocity is exact from the first step
+		constexpr float Velocity = 0.6f;
+		const double Step = Velocity * Config.MaxLinearVelocity * DeltaTime;
+		const double Alpha = DeltaTime * Config.LocationInterpolationSpeed;
+		SettleFilters(Velocity, 0.0f, 0.0f, 0.0f, Config, ServiceData);
+		ServiceData.PreviousLocation = Location;
+		ServiceData.PreviousLocation.X -= Step / Alpha - Step;
+
+		float MaxAcceleration = 0.0f;
+		float MaxJerk = 0.0f;
+		for (int Frame = 0; Frame < 60; ++Frame)
+		{
+			Location.X += Step;
+			const FMotionData MotionData = CalculateMotionData<FMotionData>(Location, FQuat4(), DeltaTime, Config, ServiceData);
+			MaxAcceleration = std::max({MaxAcceleration, MotionData.PositiveLinearAccelerationNormalized, MotionData.NegativeLinearAccelerationNormalized});
+			MaxJerk = std::max({MaxJerk, MotionData.PositiveLinearJerkNormalized, MotionData.NegativeLinearJerkNormalized});
+		}
+
+		Expect(MaxAcceleration < 1.e-3f, Name, "settled filter produces acceleration", MaxAcceleration);
+		Expect(MaxJerk < 1.e-3f, Name, "settled filter produces jerk", MaxJerk);
+	}
+}
+
+int main()
+{
+	TestIndicesAtConstantVelocity(EFilter::Exponential, "Indices/Exponential");
+	TestIndicesAtConstantVelocity(EFilter::OneEuro, "Indices/OneEuro");
+	TestIndicesAtConstantVelocity(EFilter::CriticallyDampedSpring, "Indices/CriticallyDampedSpring");
+	TestIndicesAtConstantVelocity(EFilter::Biquad, "Indices/Biquad");
+
+	TestSettleFilters(EFilter::Exponential, "Settle/Exponential");
+	TestSettleFilters(EFilter::OneEuro, "Settle/OneEuro");
+	TestSettleFilters(EFilter::CriticallyDampedSpring, "Settle/CriticallyDampedSpring");
+	TestSettleFilters(EFilter::Biquad, "Settle/Biquad");
+
+	if (NumFailures > 0)
+	{
+		std::printf("%d checks failed\n", NumFailures);
+		return 1;
+	}
+
+	std::printf("All checks passed\n");
+	return 0;
+}
@@ -0,0 +1,29 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+using UnrealBuildTool;
+
+public class MotionIntensityMass : ModuleRules
+{
+	public MotionIntensityMass(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"MassEntity",
+				"MassSpawner",
+				"MotionIntensity"
+			}
+		);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Engine",
+				"MassCommon",
+				"StructUtils"
+			}
+		);
+	}
+}
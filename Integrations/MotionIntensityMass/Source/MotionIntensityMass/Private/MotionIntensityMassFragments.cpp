@@ -0,0 +1,13 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityMassFragments.h"
+
+FMotionIntensitySharedFragment::FMotionIntensitySharedFragment(const UMotionIntensityPreset* Preset)
+{
+	if (Preset)
+	{
+		Config = Preset->MotionIntensityConfig;
+		Coefficients = Preset->Coefficients;
+	}
+	CompiledCoefficients = FMotionIntensityCompiledCoefficients(Coefficients);
+}
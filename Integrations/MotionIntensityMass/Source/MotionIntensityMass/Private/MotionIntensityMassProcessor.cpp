@@ -0,0 +1,62 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityMassProcessor.h"
+#include "MotionIntensityCoreAdapters.h"
+#include "MotionIntensityMassFragments.h"
+#include "MotionIntensityValidation.h"
+#include "MassCommonFragments.h"
+#include "MassExecutionContext.h"
+
+UMotionIntensityMassProcessor::UMotionIntensityMassProcessor()
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ProcessingPhase = EMassProcessingPhase::PostPhysics;
+}
+
+/* Protected methods */
+
+void UMotionIntensityMassProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FMotionIntensityStateFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FMotionIntensityFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddConstSharedRequirement<FMotionIntensitySharedFragment>();
+	EntityQuery.RegisterWithProcessor(*this);
+}
+
+void UMotionIntensityMassProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	const float DeltaTime = Context.GetDeltaTimeSeconds();
+	if (!MotionIntensityValidation::ValidateDeltaTime(DeltaTime))
+	{
+		return;
+	}
+
+	EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [DeltaTime](FMassExecutionContext& ChunkContext)
+	{
+		// Entities of an invalid preset keep their last results
+		const FMotionIntensitySharedFragment& SharedFragment = ChunkContext.GetConstSharedFragment<FMotionIntensitySharedFragment>();
+		if (!MotionIntensityValidation::ValidateConfig(SharedFragment.Config)
+			|| !MotionIntensityValidation::ValidateCoefficients(SharedFragment.CompiledCoefficients))
+		{
+			return;
+		}
+
+		const TConstArrayView<FTransformFragment> Transforms = ChunkContext.GetFragmentView<FTransformFragment>();
+		const TArrayView<FMotionIntensityStateFragment> States = ChunkContext.GetMutableFragmentView<FMotionIntensityStateFragment>();
+		const TArrayView<FMotionIntensityFragment> Results = ChunkContext.GetMutableFragmentView<FMotionIntensityFragment>();
+
+		const int32 Number = ChunkContext.GetNumEntities();
+		for (int32 Index = 0; Index < Number; ++Index)
+		{
+			const FTransform& Transform = Transforms[Index].GetTransform();
+			FMotionIntensityFragment& Result = Results[Index];
+			Result.MotionData = MotionIntensityCore::CalculateMotionData<FMotionIntensityMotionData>(Transform.GetLocation(),
+			                                                                                        Transform.GetRotation(),
+			                                                                                        DeltaTime,
+			                                                                                        SharedFragment.Config,
+			                                                                                        States[Index].ServiceData);
+			Result.MotionIntensity = SharedFragment.CompiledCoefficients.GetMotionIntensity(Result.MotionData);
+		}
+	});
+}
@@ -0,0 +1,20 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityMassTrait.h"
+#include "MotionIntensityMassFragments.h"
+#include "MassCommonFragments.h"
+#include "MassEntityTemplateRegistry.h"
+#include "MassEntityUtils.h"
+
+/* Protected methods */
+
+void UMotionIntensityMassTrait::BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const
+{
+	BuildContext.RequireFragment<FTransformFragment>();
+	BuildContext.AddFragment<FMotionIntensityStateFragment>();
+	BuildContext.AddFragment<FMotionIntensityFragment>();
+
+	FMassEntityManager& EntityManager = UE::Mass::Utils::GetEntityManagerChecked(World);
+	const FConstSharedStruct SharedFragment = EntityManager.GetOrCreateConstSharedFragment(FMotionIntensitySharedFragment(Preset));
+	BuildContext.AddConstSharedFragment(SharedFragment);
+}
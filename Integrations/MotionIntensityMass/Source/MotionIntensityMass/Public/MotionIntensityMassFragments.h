@@ -0,0 +1,51 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "MassEntityTypes.h"
+#include "MotionIntensity.h"
+#include "MotionIntensityMassFragments.generated.h"
+
+// State an entity carries between updates, the same Service Data the Blueprint library works with
+USTRUCT()
+struct FMotionIntensityStateFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FMotionIntensityServiceData ServiceData;
+};
+
+// Results of the latest update, kept apart from the state so readers don't pull it into cache
+USTRUCT()
+struct FMotionIntensityFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FMotionIntensityMotionData MotionData;
+
+	UPROPERTY()
+	float MotionIntensity = 0.0f;
+};
+
+// Config and coefficients of a preset, shared by every entity of the archetype and compiled once
+USTRUCT()
+struct FMotionIntensitySharedFragment : public FMassConstSharedFragment
+{
+	GENERATED_BODY()
+
+	FMotionIntensitySharedFragment() = default;
+
+	explicit FMotionIntensitySharedFragment(const UMotionIntensityPreset* Preset);
+
+	UPROPERTY()
+	FMotionIntensityConfig Config;
+
+	// Entities of presets with equal config and coefficients share one fragment
+	UPROPERTY()
+	FMotionIntensityCoefficients Coefficients;
+
+	UPROPERTY()
+	FMotionIntensityCompiledCoefficients CompiledCoefficients;
+};
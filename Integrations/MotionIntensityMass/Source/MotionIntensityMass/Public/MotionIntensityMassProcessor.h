@@ -0,0 +1,24 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "MassProcessor.h"
+#include "MotionIntensityMassProcessor.generated.h"
+
+// Updates motion intensity of every entity with the fragments of UMotionIntensityMassTrait from its transform.
+// Archetype chunks are evaluated in parallel, in the post-physics phase so movement of the frame is already applied.
+UCLASS()
+class MOTIONINTENSITYMASS_API UMotionIntensityMassProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UMotionIntensityMassProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
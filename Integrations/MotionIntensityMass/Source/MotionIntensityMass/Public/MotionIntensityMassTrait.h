@@ -0,0 +1,22 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "MassEntityTraitBase.h"
+#include "MotionIntensityMassTrait.generated.h"
+
+class UMotionIntensityPreset;
+
+// Adds motion intensity to entities with a transform, updated by UMotionIntensityMassProcessor
+UCLASS(meta = (DisplayName = "Motion Intensity"))
+class MOTIONINTENSITYMASS_API UMotionIntensityMassTrait : public UMassEntityTraitBase
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const override;
+
+	// Config and coefficients, defaults are used if not set
+	UPROPERTY(EditAnywhere, Category = "Motion Intensity")
+	TObjectPtr<UMotionIntensityPreset> Preset;
+};
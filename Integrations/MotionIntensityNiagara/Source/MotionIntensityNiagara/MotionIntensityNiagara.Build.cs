@@ -0,0 +1,28 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+using UnrealBuildTool;
+
+public class MotionIntensityNiagara : ModuleRules
+{
+	public MotionIntensityNiagara(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Niagara",
+				"MotionIntensity"
+			}
+		);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Engine",
+				"NiagaraCore",
+				"VectorVM"
+			}
+		);
+	}
+}
@@ -0,0 +1,5 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, MotionIntensityNiagara)
@@ -0,0 +1,227 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityNiagaraDataInterface.h"
+#include "MotionIntensity.h"
+#include "MotionIntensityValidation.h"
+#include "NiagaraTypes.h"
+
+#define LOCTEXT_NAMESPACE "MotionIntensityNiagaraDataInterface"
+
+static const FName CalculateMotionIntensityName(TEXT("CalculateMotionIntensity"));
+
+// Particles per pass through the batch kernel, the state of a pass lives on the stack.
+// Multiple of the SIMD width, so only the last pass of a VM chunk has a scalar tail.
+static constexpr int32 MotionIntensityNiagaraChunkSize = 64;
+static_assert(MotionIntensityNiagaraChunkSize % MotionIntensityCore::Simd::Width == 0);
+
+static void CalculateMotionIntensity(FVectorVMExternalFunctionContext& Context,
+                                     const FMotionIntensityConfig& Config,
+                                     const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+                                     const bool bIsValid)
+{
+	FNDIInputParam<FVector3f> InPosition(Context);
+	FNDIInputParam<FQuat4f> InRotation(Context);
+	FNDIInputParam<float> InDeltaTime(Context);
+	FNDIInputParam<bool> InInitialized(Context);
+	FNDIInputParam<FVector3f> InPreviousPosition(Context);
+	FNDIInputParam<FQuat4f> InPreviousRotation(Context);
+	FNDIInputParam<float> InPreviousLinearVelocity(Context);
+	FNDIInputParam<float> InPreviousLinearAcceleration(Context);
+	FNDIInputParam<float> InPreviousAngularVelocity(Context);
+	FNDIInputParam<float> InPreviousAngularAcceleration(Context);
+
+	FNDIOutputParam<float> OutMotionIntensity(Context);
+	FNDIOutputParam<bool> OutInitialized(Context);
+	FNDIOutputParam<FVector3f> OutPreviousPosition(Context);
+	FNDIOutputParam<FQuat4f> OutPreviousRotation(Context);
+	FNDIOutputParam<float> OutPreviousLinearVelocity(Context);
+	FNDIOutputParam<float> OutPreviousLinearAcceleration(Context);
+	FNDIOutputParam<float> OutPreviousAngularVelocity(Context);
+	FNDIOutputParam<float> OutPreviousAngularAcceleration(Context);
+
+	constexpr int32 ChunkSize = MotionIntensityNiagaraChunkSize;
+	MotionIntensityCore::FFloatVector3 Locations[ChunkSize];
+	MotionIntensityCore::FFloatQuat4 Rotations[ChunkSize];
+	bool SetPreviousTransformToCurrent[ChunkSize];
+	MotionIntensityCore::FFloatVector3 PreviousLocations[ChunkSize];
+	MotionIntensityCore::FFloatQuat4 PreviousRotations[ChunkSize];
+	float PreviousLinearVelocities[ChunkSize];
+	float PreviousLinearAccelerations[ChunkSize];
+	float PreviousAngularVelocities[ChunkSize];
+	float PreviousAngularAccelerations[ChunkSize];
+	float MotionIntensities[ChunkSize];
+
+	// Only used by the filters and fixed steps the particles don't have state for
+	MotionIntensityCore::FFilterState FilterStates[ChunkSize];
+	float TimeAccumulators[ChunkSize];
+	MotionIntensityCore::FPackedMotionData FixedStepMotionData[ChunkSize];
+
+	MotionIntensityCore::TBatchView<MotionIntensityCore::FFloatVector3, MotionIntensityCore::FFloatQuat4> View;
+	View.SetPreviousTransformToCurrent = SetPreviousTransformToCurrent;
+	View.PreviousLocations = PreviousLocations;
+	View.PreviousRotations = PreviousRotations;
+	View.PreviousLinearVelocities = PreviousLinearVelocities;
+	View.PreviousLinearAccelerations = PreviousLinearAccelerations;
+	View.PreviousAngularVelocities = PreviousAngularVelocities;
+	View.PreviousAngularAccelerations = PreviousAngularAccelerations;
+	View.LinearVelocityFilterStates = FilterStates;
+	View.LinearAccelerationFilterStates = FilterStates;
+	View.AngularVelocityFilterStates = FilterStates;
+	View.AngularAccelerationFilterStates = FilterStates;
+	View.TimeAccumulators = TimeAccumulators;
+	View.FixedStepMotionData = FixedStepMotionData;
+
+	auto OutputFunction = [&MotionIntensities, &CompiledCoefficients](const int32 Index, const MotionIntensityCore::FPackedMotionData& MotionData)
+	{
+		MotionIntensities[Index] = CompiledCoefficients.GetMotionIntensity(MotionData);
+	};
+
+	for (int32 Begin = 0; Begin < Context.GetNumInstances(); Begin += ChunkSize)
+	{
+		const int32 Count = FMath::Min(Context.GetNumInstances() - Begin, ChunkSize);
+
+		// Delta Time is expected to be the same for all particles, e.g. Engine.DeltaTime
+		float DeltaTime = 0.0f;
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			const FVector3f Position = InPosition.GetAndAdvance();
+			const FQuat4f Rotation = InRotation.GetAndAdvance();
+			const FVector3f PreviousPosition = InPreviousPosition.GetAndAdvance();
+			const FQuat4f PreviousRotation = InPreviousRotation.GetAndAdvance();
+			DeltaTime = InDeltaTime.GetAndAdvance();
+
+			Locations[Index] = {Position.X, Position.Y, Position.Z};
+			Rotations[Index] = {Rotation.X, Rotation.Y, Rotation.Z, Rotation.W};
+			SetPreviousTransformToCurrent[Index] = !InInitialized.GetAndAdvance();
+			PreviousLocations[Index] = {PreviousPosition.X, PreviousPosition.Y, PreviousPosition.Z};
+			PreviousRotations[Index] = {PreviousRotation.X, PreviousRotation.Y, PreviousRotation.Z, PreviousRotation.W};
+			PreviousLinearVelocities[Index] = InPreviousLinearVelocity.GetAndAdvance();
+			PreviousLinearAccelerations[Index] = InPreviousLinearAcceleration.GetAndAdvance();
+			PreviousAngularVelocities[Index] = InPreviousAngularVelocity.GetAndAdvance();
+			PreviousAngularAccelerations[Index] = InPreviousAngularAcceleration.GetAndAdvance();
+		}
+
+		// A paused or invalid update passes the state through unchanged, intensity isn't part of the state so it reads 0
+		const bool bEvaluate = bIsValid && DeltaTime > 0.0f;
+		if (bEvaluate)
+		{
+			MotionIntensityCore::EvaluateRange(View, 0, Count, Locations, Rotations, DeltaTime, Config, true, OutputFunction);
+		}
+
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			const MotionIntensityCore::FFloatVector3& PreviousLocation = PreviousLocations[Index];
+			const MotionIntensityCore::FFloatQuat4& PreviousRotation = PreviousRotations[Index];
+
+			OutMotionIntensity.SetAndAdvance(bEvaluate ? MotionIntensities[Index] : 0.0f);
+			OutInitialized.SetAndAdvance(!SetPreviousTransformToCurrent[Index]);
+			OutPreviousPosition.SetAndAdvance(FVector3f(PreviousLocation.X, PreviousLocation.Y, PreviousLocation.Z));
+			OutPreviousRotation.SetAndAdvance(FQuat4f(PreviousRotation.X, PreviousRotation.Y, PreviousRotation.Z, PreviousRotation.W));
+			OutPreviousLinearVelocity.SetAndAdvance(PreviousLinearVelocities[Index]);
+			OutPreviousLinearAcceleration.SetAndAdvance(PreviousLinearAccelerations[Index]);
+			OutPreviousAngularVelocity.SetAndAdvance(PreviousAngularVelocities[Index]);
+			OutPreviousAngularAcceleration.SetAndAdvance(PreviousAngularAccelerations[Index]);
+		}
+	}
+}
+
+/* Public methods */
+
+void UNiagaraDataInterfaceMotionIntensity::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		const ENiagaraTypeRegistryFlags Flags = ENiagaraTypeRegistryFlags::AllowAnyVariable | ENiagaraTypeRegistryFlags::AllowParameter;
+		FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), Flags);
+	}
+}
+
+void UNiagaraDataInterfaceMotionIntensity::GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo,
+                                                                 void* InstanceData,
+                                                                 FVMExternalFunction& OutFunc)
+{
+	if (BindingInfo.Name != CalculateMotionIntensityName)
+	{
+		return;
+	}
+
+	// Resolved once per binding, the simulation reinitializes when the preset changes
+	FMotionIntensityConfig Config = Preset ? Preset->MotionIntensityConfig : FMotionIntensityConfig();
+	Config.Filter = EMotionIntensityFilter::Exponential;
+	Config.bUseFixedTimeStep = false;
+
+	const FMotionIntensityCompiledCoefficients CompiledCoefficients(Preset ? Preset->Coefficients : FMotionIntensityCoefficients());
+	const bool bIsValid = MotionIntensityValidation::ValidateConfig(Config)
+		&& MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients);
+
+	OutFunc = FVMExternalFunction::CreateLambda([Config, CompiledCoefficients, bIsValid](FVectorVMExternalFunctionContext& Context)
+	{
+		CalculateMotionIntensity(Context, Config, CompiledCoefficients, bIsValid);
+	});
+}
+
+bool UNiagaraDataInterfaceMotionIntensity::CanExecuteOnTarget(const ENiagaraSimTarget Target) const
+{
+	return Target == ENiagaraSimTarget::CPUSim;
+}
+
+bool UNiagaraDataInterfaceMotionIntensity::Equals(const UNiagaraDataInterface* Other) const
+{
+	if (!Super::Equals(Other))
+	{
+		return false;
+	}
+
+	return CastChecked<const UNiagaraDataInterfaceMotionIntensity>(Other)->Preset == Preset;
+}
+
+/* Protected methods */
+
+#if WITH_EDITORONLY_DATA
+void UNiagaraDataInterfaceMotionIntensity::GetFunctionsInternal(TArray<FNiagaraFunctionSignature>& OutFunctions) const
+{
+	FNiagaraFunctionSignature& Signature = OutFunctions.AddDefaulted_GetRef();
+	Signature.Name = CalculateMotionIntensityName;
+	Signature.bMemberFunction = true;
+	Signature.bRequiresContext = false;
+	Signature.bSupportsGPU = false;
+	Signature.SetDescription(LOCTEXT("CalculateMotionIntensityDescription",
+		"Calculates motion intensity of the particle, read its state from particle attributes and write the outputs back"));
+
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition(GetClass()), TEXT("MotionIntensity")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetPositionDef(), TEXT("Position")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetQuatDef(), TEXT("Rotation")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("DeltaTime")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetBoolDef(), TEXT("Initialized")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetPositionDef(), TEXT("PreviousPosition")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetQuatDef(), TEXT("PreviousRotation")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("PreviousLinearVelocity")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("PreviousLinearAcceleration")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("PreviousAngularVelocity")));
+	Signature.AddInput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("PreviousAngularAcceleration")));
+
+	Signature.AddOutput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("MotionIntensity")));
+	Signature.AddOutput(FNiagaraVariable(FNiagaraTypeDefinition::GetBoolDef(), TEXT("Initialized")));
+	Signature.AddOutput(FNiagaraVariable(FNiagaraTypeDefinition::GetPositionDef(), TEXT("PreviousPosition")));
+	Signature.AddOutput(FNiagaraVariable(FNiagaraTypeDefinition::GetQuatDef(), TEXT("PreviousRotation")));
+	Signature.AddOutput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("PreviousLinearVelocity")));
+	Signature.AddOutput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("PreviousLinearAcceleration")));
+	Signature.AddOutput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("PreviousAngularVelocity")));
+	Signature.AddOutput(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("PreviousAngularAcceleration")));
+}
+#endif
+
+bool UNiagaraDataInterfaceMotionIntensity::CopyToInternal(UNiagaraDataInterface* Destination) const
+{
+	if (!Super::CopyToInternal(Destination))
+	{
+		return false;
+	}
+
+	CastChecked<UNiagaraDataInterfaceMotionIntensity>(Destination)->Preset = Preset;
+	return true;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,40 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "NiagaraDataInterface.h"
+#include "MotionIntensityNiagaraDataInterface.generated.h"
+
+class UMotionIntensityPreset;
+
+// Calculates per-particle motion intensity in CPU simulations, without any game thread work.
+// Particles carry their own state as attributes: read them into the function and write its outputs back, starting with
+// Initialized set to false. Particles are evaluated in chunks with the vectorized batch kernel.
+// The state holds no filter memory, so the preset is always evaluated with the exponential filter at the simulation's
+// update rate, its filter and fixed time step are ignored.
+// While the simulation is paused, or if the preset is invalid, the state passes through unchanged and motion intensity
+// reads 0.
+UCLASS(EditInlineNew, Category = "Motion Intensity", CollapseCategories, meta = (DisplayName = "Motion Intensity"))
+class MOTIONINTENSITYNIAGARA_API UNiagaraDataInterfaceMotionIntensity : public UNiagaraDataInterface
+{
+	GENERATED_BODY()
+
+public:
+	// Config and coefficients, defaults are used if not set
+	UPROPERTY(EditAnywhere, Category = "Motion Intensity")
+	TObjectPtr<UMotionIntensityPreset> Preset;
+
+	virtual void PostInitProperties() override;
+
+	virtual void GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo,
+	                                   void* InstanceData,
+	                                   FVMExternalFunction& OutFunc) override;
+	virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override;
+	virtual bool Equals(const UNiagaraDataInterface* Other) const override;
+
+protected:
+#if WITH_EDITORONLY_DATA
+	virtual void GetFunctionsInternal(TArray<FNiagaraFunctionSignature>& OutFunctions) const override;
+#endif
+	virtual bool CopyToInternal(UNiagaraDataInterface* Destination) const override;
+};
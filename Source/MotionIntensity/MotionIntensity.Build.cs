@@ -11,7 +11,9 @@ public class MotionIntensity : ModuleRules
 			{
 				"Core",
 				"CoreUObject",
-				"Engine"
+				"Engine",
+				"PhysicsCore",
+				"Chaos"
 			}
 		);
 	}
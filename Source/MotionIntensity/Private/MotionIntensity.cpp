@@ -1,11 +1,24 @@
 ﻿// Copyright (c) 2024 Tyoma Makeev
 
 #include "MotionIntensity.h"
+#include "MotionIntensityCoreAdapters.h"
+#include "MotionIntensityStats.h"
+#include "MotionIntensityValidation.h"
 
 IMPLEMENT_MODULE(FMotionIntensityModule, MotionIntensity)
 
 DEFINE_LOG_CATEGORY(MotionIntensityLog);
 
+DEFINE_STAT(STAT_MotionIntensity_CalculateMotionData);
+DEFINE_STAT(STAT_MotionIntensity_GetMotionIntensity);
+DEFINE_STAT(STAT_MotionIntensity_BatchEvaluate);
+DEFINE_STAT(STAT_MotionIntensity_SubsystemTick);
+DEFINE_STAT(STAT_MotionIntensity_EvaluateTrack);
+DEFINE_STAT(STAT_MotionIntensity_SkeletalTick);
+DEFINE_STAT(STAT_MotionIntensity_ObjectsEvaluated);
+DEFINE_STAT(STAT_MotionIntensity_OriginRebases);
+DEFINE_STAT(STAT_MotionIntensity_RejectedCalls);
+
 /* Public methods */
 
 FMotionIntensityMotionData UMotionIntensityFunctionLibrary::CalculateMotionData(const FVector Location,
@@ -14,135 +27,61 @@ FMotionIntensityMotionData UMotionIntensityFunctionLibrary::CalculateMotionData(
                                                                                 const FMotionIntensityConfig& Config,
                                                                                 FMotionIntensityServiceData& ServiceData)
 {
-	if (DeltaTime <= 0.0f)
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_CalculateMotionData);
+
+	if (!MotionIntensityValidation::ValidateDeltaTime(DeltaTime))
 	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("Delta Time should be larger than zero"));
 		return FMotionIntensityMotionData();
 	}
 
 	const FQuat RotationQuat = Rotation.Quaternion();
 
-	if (!Config.IsValid())
+	if (!MotionIntensityValidation::ValidateConfig(Config))
 	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("MotionIntensityConfig is invalid"));
 		return FMotionIntensityMotionData();
 	}
 
-	if (ServiceData.bSetPreviousTransformToCurrent)
-	{
-		ServiceData.PreviousLocation = Location;
-		ServiceData.PreviousRotation = RotationQuat;
-		ServiceData.bSetPreviousTransformToCurrent = false;
-	}
-
-	FMotionIntensityMotionData MotionData;
-
-	if (Config.bCalculateLinearMotion)
-	{
-		CalculateLinearMotionData(Location, DeltaTime, Config, ServiceData, MotionData);
-	}
-	if (Config.bCalculateAngularMotion)
-	{
-		CalculateAngularMotionData(RotationQuat, DeltaTime, Config, ServiceData, MotionData);
-	}
-
-	return MotionData;
+	INC_DWORD_STAT(STAT_MotionIntensity_ObjectsEvaluated);
+	return MotionIntensityCore::CalculateMotionData<FMotionIntensityMotionData>(Location, RotationQuat, DeltaTime, Config, ServiceData);
 }
 
 float UMotionIntensityFunctionLibrary::GetLinearMotionIntensityFromMotionData(const FMotionIntensityMotionData& MotionData,
                                                                               const FMotionIntensityCoefficients& Coefficients)
 {
-	if (!Coefficients.IsValid())
-	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("MotionIntensityCoefficients is invalid"));
-		return 0.0f;
-	}
-
-	const float SumOfSquares = FMath::Square(MotionData.LinearVelocityNormalized * Coefficients.LinearVelocityCoefficient)
-		+ FMath::Square(MotionData.PositiveLinearAccelerationNormalized * Coefficients.PositiveLinearAccelerationCoefficient)
-		+ FMath::Square(MotionData.NegativeLinearAccelerationNormalized * Coefficients.NegativeLinearAccelerationCoefficient)
-		+ FMath::Square(MotionData.PositiveLinearJerkNormalized * Coefficients.PositiveLinearJerkCoefficient)
-		+ FMath::Square(MotionData.NegativeLinearJerkNormalized * Coefficients.NegativeLinearJerkCoefficient);
-
-	if (SumOfSquares == 0.0f)
-	{
-		return 0.0f;
-	}
-
-	const float LinearMotionIntensity = FMath::Sqrt(SumOfSquares);
-
-	const float MaxPossibleLinearMotionIntensity = FMath::Sqrt(
-		FMath::Square(Coefficients.LinearVelocityCoefficient)
-		+ FMath::Square(Coefficients.PositiveLinearAccelerationCoefficient)
-		+ FMath::Square(Coefficients.NegativeLinearAccelerationCoefficient)
-		+ FMath::Square(Coefficients.PositiveLinearJerkCoefficient)
-		+ FMath::Square(Coefficients.NegativeLinearJerkCoefficient)
-	);
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_GetMotionIntensity);
 
-	if (MaxPossibleLinearMotionIntensity == 0.0f)
+	if (!MotionIntensityValidation::ValidateCoefficients(Coefficients))
 	{
 		return 0.0f;
 	}
 
-	return (LinearMotionIntensity / MaxPossibleLinearMotionIntensity) * Coefficients.MotionIntensityMultiplier;
+	return MotionIntensityCore::GetLinearMotionIntensityFromMotionData(MotionData, Coefficients);
 }
 
 float UMotionIntensityFunctionLibrary::GetAngularMotionIntensityFromMotionData(const FMotionIntensityMotionData& MotionData,
                                                                                const FMotionIntensityCoefficients& Coefficients)
 {
-	if (!Coefficients.IsValid())
-	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("MotionIntensityCoefficients is invalid"));
-		return 0.0f;
-	}
-
-	const float SumOfSquares = FMath::Square(MotionData.AngularVelocityNormalized * Coefficients.AngularVelocityCoefficient)
-		+ FMath::Square(MotionData.PositiveAngularAccelerationNormalized * Coefficients.PositiveAngularAccelerationCoefficient)
-		+ FMath::Square(MotionData.NegativeAngularAccelerationNormalized * Coefficients.NegativeAngularAccelerationCoefficient)
-		+ FMath::Square(MotionData.PositiveAngularJerkNormalized * Coefficients.PositiveAngularJerkCoefficient)
-		+ FMath::Square(MotionData.NegativeAngularJerkNormalized * Coefficients.NegativeAngularJerkCoefficient);
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_GetMotionIntensity);
 
-	if (SumOfSquares == 0.0f)
+	if (!MotionIntensityValidation::ValidateCoefficients(Coefficients))
 	{
 		return 0.0f;
 	}
 
-	const float AngularMotionIntensity = FMath::Sqrt(SumOfSquares);
-
-	const float MaxPossibleAngularMotionIntensity = FMath::Sqrt(
-		FMath::Square(Coefficients.AngularVelocityCoefficient)
-		+ FMath::Square(Coefficients.PositiveAngularAccelerationCoefficient)
-		+ FMath::Square(Coefficients.NegativeAngularAccelerationCoefficient)
-		+ FMath::Square(Coefficients.PositiveAngularJerkCoefficient)
-		+ FMath::Square(Coefficients.NegativeAngularJerkCoefficient)
-	);
-
-	if (MaxPossibleAngularMotionIntensity == 0.0f)
-	{
-		return 0.0f;
-	}
-
-	return (AngularMotionIntensity / MaxPossibleAngularMotionIntensity) * Coefficients.MotionIntensityMultiplier;
+	return MotionIntensityCore::GetAngularMotionIntensityFromMotionData(MotionData, Coefficients);
 }
 
 float UMotionIntensityFunctionLibrary::GetMotionIntensityFromMotionData(const FMotionIntensityMotionData& MotionData,
                                                                         const FMotionIntensityCoefficients& Coefficients)
 {
-	if (!Coefficients.IsValid())
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_GetMotionIntensity);
+
+	if (!MotionIntensityValidation::ValidateCoefficients(Coefficients))
 	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("MotionIntensityCoefficients is invalid"));
 		return 0.0f;
 	}
 
-	const float LinearMotionIntensity = GetLinearMotionIntensityFromMotionData(MotionData, Coefficients);
-	const float AngularMotionIntensity = GetAngularMotionIntensityFromMotionData(MotionData, Coefficients);
-
-	const float MotionIntensity = FMath::Sqrt(
-		FMath::Square(LinearMotionIntensity) +
-		FMath::Square(AngularMotionIntensity)
-	) / UE_SQRT_2;
-
-	return MotionIntensity;
+	return MotionIntensityCore::GetMotionIntensityFromMotionData(MotionData, Coefficients);
 }
 
 float UMotionIntensityFunctionLibrary::GetMotionIntensity(const FVector Location,
@@ -152,130 +91,123 @@ float UMotionIntensityFunctionLibrary::GetMotionIntensity(const FVector Location
                                                           FMotionIntensityServiceData& ServiceData,
                                                           const FMotionIntensityCoefficients& Coefficients)
 {
-	const FMotionIntensityMotionData MotionData = CalculateMotionData(Location, Rotation, DeltaTime, Config, ServiceData);
-	return GetMotionIntensityFromMotionData(MotionData, Coefficients);
-}
+	FMotionIntensityMotionData MotionData;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_CalculateMotionData);
 
-/* Private methods */
+		// Everything is checked once here, the core below runs unchecked
+		if (!MotionIntensityValidation::ValidateDeltaTime(DeltaTime) || !MotionIntensityValidation::ValidateConfig(Config))
+		{
+			return 0.0f;
+		}
 
-float UMotionIntensityFunctionLibrary::GetSmoothedDerivative(const float Current,
-                                                             float& OutPrevious,
-                                                             const float DeltaTime,
-                                                             const float InterpolationSpeed)
-{
-	if (DeltaTime <= 0.0f)
+		INC_DWORD_STAT(STAT_MotionIntensity_ObjectsEvaluated);
+		MotionData = MotionIntensityCore::CalculateMotionData<FMotionIntensityMotionData>(Location, Rotation.Quaternion(), DeltaTime, Config, ServiceData);
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_GetMotionIntensity);
+
+	// Service Data advances even with invalid coefficients, so it doesn't jump once they're fixed
+	if (!MotionIntensityValidation::ValidateCoefficients(Coefficients))
 	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("Delta Time should be larger than zero"));
 		return 0.0f;
 	}
-	const float SmoothedValue = FMath::FInterpTo(OutPrevious, Current, DeltaTime, InterpolationSpeed);
-	const float Derivative = (SmoothedValue - OutPrevious) / DeltaTime;
-	OutPrevious = SmoothedValue;
-	return Derivative;
+
+	return MotionIntensityCore::GetMotionIntensityFromMotionData(MotionData, Coefficients);
 }
 
-float UMotionIntensityFunctionLibrary::GetLinearVelocitySmoothed(const FVector& Current,
-                                                                 FVector& OutPrevious,
-                                                                 const float DeltaTime,
-                                                                 const float InterpolationSpeed)
+FMotionIntensityMotionData UMotionIntensityFunctionLibrary::CalculateMotionDataFromVelocity(const FVector LinearVelocity,
+                                                                                            const FVector AngularVelocity,
+                                                                                            const float DeltaTime,
+                                                                                            const FMotionIntensityConfig& Config,
+                                                                                            FMotionIntensityServiceData& ServiceData)
 {
-	if (DeltaTime <= 0.0f)
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_CalculateMotionData);
+
+	if (!MotionIntensityValidation::ValidateDeltaTime(DeltaTime) || !MotionIntensityValidation::ValidateConfig(Config))
 	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("Delta Time should be larger than zero"));
-		return 0.0f;
+		return FMotionIntensityMotionData();
 	}
-	const FVector SmoothedValue = FMath::VInterpTo(OutPrevious, Current, DeltaTime, InterpolationSpeed);
-	const float Derivative = (SmoothedValue - OutPrevious).Length() / DeltaTime;
-	OutPrevious = SmoothedValue;
-	return Derivative;
+
+	INC_DWORD_STAT(STAT_MotionIntensity_ObjectsEvaluated);
+	return MotionIntensityCore::CalculateMotionDataFromVelocity<FMotionIntensityMotionData>(static_cast<float>(LinearVelocity.Size()),
+	                                                                                       static_cast<float>(AngularVelocity.Size() / UE_TWO_PI), // Radians to revolutions
+	                                                                                       DeltaTime,
+	                                                                                       Config,
+	                                                                                       ServiceData);
 }
 
-float UMotionIntensityFunctionLibrary::GetAngularVelocitySmoothed(const FQuat& Current,
-                                                                  FQuat& OutPrevious,
-                                                                  const float DeltaTime,
-                                                                  const float InterpolationSpeed)
+float UMotionIntensityFunctionLibrary::GetMotionIntensityFromVelocity(const FVector LinearVelocity,
+                                                                      const FVector AngularVelocity,
+                                                                      const float DeltaTime,
+                                                                      const FMotionIntensityConfig& Config,
+                                                                      FMotionIntensityServiceData& ServiceData,
+                                                                      const FMotionIntensityCoefficients& Coefficients)
 {
-	if (DeltaTime <= 0.0f)
+	const FMotionIntensityMotionData MotionData = CalculateMotionDataFromVelocity(LinearVelocity, AngularVelocity, DeltaTime, Config, ServiceData);
+
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_GetMotionIntensity);
+
+	// Service Data advances even with invalid coefficients, so it doesn't jump once they're fixed
+	if (!MotionIntensityValidation::ValidateCoefficients(Coefficients))
 	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("Delta Time should be larger than zero"));
 		return 0.0f;
 	}
-	const FQuat SmoothedValue = FMath::QInterpTo(OutPrevious, Current, DeltaTime, InterpolationSpeed);
-	const float Revolutions = SmoothedValue.AngularDistance(OutPrevious) / (2.0f * PI); // Convert radians to revolutions
-	OutPrevious = SmoothedValue;
-	return Revolutions / DeltaTime;
+
+	return MotionIntensityCore::GetMotionIntensityFromMotionData(MotionData, Coefficients);
 }
 
-void UMotionIntensityFunctionLibrary::CalculateLinearMotionData(const FVector& CurrentLocation,
-                                                                const float DeltaTime,
-                                                                const FMotionIntensityConfig& Config,
-                                                                FMotionIntensityServiceData& ServiceData,
-                                                                FMotionIntensityMotionData& OutMotionData)
+FMotionIntensityCompiledCoefficients UMotionIntensityFunctionLibrary::CompileCoefficients(const FMotionIntensityCoefficients& Coefficients)
 {
-	if (DeltaTime <= 0.0f)
-	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("Delta Time should be larger than zero"));
-		return;
-	}
+	MotionIntensityValidation::ValidateCoefficients(Coefficients);
+	return FMotionIntensityCompiledCoefficients(Coefficients);
+}
 
-	OutMotionData.LinearVelocityNormalized = GetLinearVelocitySmoothed(CurrentLocation,
-	                                                                   ServiceData.PreviousLocation,
-	                                                                   DeltaTime,
-	                                                                   Config.LocationInterpolationSpeed) / Config.MaxLinearVelocity;
+float UMotionIntensityFunctionLibrary::GetLinearMotionIntensityFromMotionDataCompiled(const FMotionIntensityMotionData& MotionData,
+                                                                                      const FMotionIntensityCompiledCoefficients& CompiledCoefficients)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_GetMotionIntensity);
 
-	if (Config.bClampLinearVelocity)
+	if (!MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients))
 	{
-		OutMotionData.LinearVelocityNormalized = FMath::Min(1.0f, OutMotionData.LinearVelocityNormalized);
+		return 0.0f;
 	}
 
-	const float LinearAccelerationNormalized = GetSmoothedDerivative(OutMotionData.LinearVelocityNormalized,
-	                                                                 ServiceData.PreviousLinearVelocity,
-	                                                                 DeltaTime,
-	                                                                 Config.LinearVelocityInterpolationSpeed) / Config.LinearVelocityInterpolationSpeed;
-	const float LinearJerkNormalized = GetSmoothedDerivative(LinearAccelerationNormalized,
-	                                                         ServiceData.PreviousLinearAcceleration,
-	                                                         DeltaTime,
-	                                                         Config.LinearAccelerationInterpolationSpeed) / Config.LinearAccelerationInterpolationSpeed;
-
-	OutMotionData.PositiveLinearAccelerationNormalized = FMath::Max(0.0f, LinearAccelerationNormalized);
-	OutMotionData.NegativeLinearAccelerationNormalized = FMath::Abs(FMath::Min(0.0f, LinearAccelerationNormalized));
-	OutMotionData.PositiveLinearJerkNormalized = FMath::Max(0.0f, LinearJerkNormalized);
-	OutMotionData.NegativeLinearJerkNormalized = FMath::Abs(FMath::Min(0.0f, LinearJerkNormalized));
+	return CompiledCoefficients.GetLinearMotionIntensity(MotionData);
 }
 
-void UMotionIntensityFunctionLibrary::CalculateAngularMotionData(const FQuat& CurrentRotation,
-                                                                 const float DeltaTime,
-                                                                 const FMotionIntensityConfig& Config,
-                                                                 FMotionIntensityServiceData& ServiceData,
-                                                                 FMotionIntensityMotionData& OutMotionData)
+float UMotionIntensityFunctionLibrary::GetAngularMotionIntensityFromMotionDataCompiled(const FMotionIntensityMotionData& MotionData,
+                                                                                       const FMotionIntensityCompiledCoefficients& CompiledCoefficients)
 {
-	if (DeltaTime <= 0.0f)
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_GetMotionIntensity);
+
+	if (!MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients))
 	{
-		UE_LOG(MotionIntensityLog, Error, TEXT("Delta Time should be larger than zero"));
-		return;
+		return 0.0f;
 	}
 
-	OutMotionData.AngularVelocityNormalized = GetAngularVelocitySmoothed(CurrentRotation,
-	                                                                     ServiceData.PreviousRotation,
-	                                                                     DeltaTime,
-	                                                                     Config.RotationInterpolationSpeed) / Config.MaxAngularVelocity;
+	return CompiledCoefficients.GetAngularMotionIntensity(MotionData);
+}
+
+float UMotionIntensityFunctionLibrary::GetMotionIntensityFromMotionDataCompiled(const FMotionIntensityMotionData& MotionData,
+                                                                                const FMotionIntensityCompiledCoefficients& CompiledCoefficients)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_GetMotionIntensity);
 
-	if (Config.bClampAngularVelocity)
+	if (!MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients))
 	{
-		OutMotionData.AngularVelocityNormalized = FMath::Min(1.0f, OutMotionData.AngularVelocityNormalized);
+		return 0.0f;
 	}
 
-	const float AngularAccelerationNormalized = GetSmoothedDerivative(OutMotionData.AngularVelocityNormalized,
-	                                                                  ServiceData.PreviousAngularVelocity,
-	                                                                  DeltaTime,
-	                                                                  Config.AngularVelocityInterpolationSpeed) / Config.AngularVelocityInterpolationSpeed;
-	const float AngularJerkNormalized = GetSmoothedDerivative(AngularAccelerationNormalized,
-	                                                          ServiceData.PreviousAngularAcceleration,
-	                                                          DeltaTime,
-	                                                          Config.AngularAccelerationInterpolationSpeed) / Config.AngularAccelerationInterpolationSpeed;
-
-	OutMotionData.PositiveAngularAccelerationNormalized = FMath::Max(0.0f, AngularAccelerationNormalized);
-	OutMotionData.NegativeAngularAccelerationNormalized = FMath::Abs(FMath::Min(0.0f, AngularAccelerationNormalized));
-	OutMotionData.PositiveAngularJerkNormalized = FMath::Max(0.0f, AngularJerkNormalized);
-	OutMotionData.NegativeAngularJerkNormalized = FMath::Abs(FMath::Min(0.0f, AngularJerkNormalized));
+	return CompiledCoefficients.GetMotionIntensity(MotionData);
+}
+
+int64 UMotionIntensityFunctionLibrary::GetErrorCount(const EMotionIntensityError Error)
+{
+	return MotionIntensityValidation::GetErrorCount(Error);
+}
+
+void UMotionIntensityFunctionLibrary::ResetErrorCounts()
+{
+	MotionIntensityValidation::ResetErrorCounts();
 }
@@ -0,0 +1,155 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityAnimNode.h"
+#include "MotionIntensityCoreAdapters.h"
+#include "MotionIntensityStats.h"
+#include "MotionIntensityValidation.h"
+#include "Animation/AnimInstanceProxy.h"
+
+/* Public methods */
+
+void FAnimNode_MotionIntensity::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	FAnimNode_Base::Initialize_AnyThread(Context);
+	Source.Initialize(Context);
+
+	ResetMotionIntensity();
+}
+
+void FAnimNode_MotionIntensity::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+	FAnimNode_Base::CacheBones_AnyThread(Context);
+	Source.CacheBones(Context);
+
+	Bone.Initialize(Context.AnimInstanceProxy->GetRequiredBones());
+}
+
+void FAnimNode_MotionIntensity::Update_AnyThread(const FAnimationUpdateContext& Context)
+{
+	GetEvaluateGraphExposedInputs().Execute(Context);
+	Source.Update(Context);
+
+	// A paused update holds the latest results
+	const float DeltaTime = Context.GetDeltaTime();
+	if (DeltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	if (SampleSource == EMotionIntensityAnimSource::ComponentTransform)
+	{
+		Sample(Context.AnimInstanceProxy->GetComponentTransform(), DeltaTime);
+	}
+	else
+	{
+		PendingDeltaTime += DeltaTime;
+	}
+}
+
+void FAnimNode_MotionIntensity::Evaluate_AnyThread(FPoseContext& Output)
+{
+	Source.Evaluate(Output);
+
+	// Pose evaluated again in the same update, e.g. from a second link to a cached pose, was already sampled
+	if (SampleSource != EMotionIntensityAnimSource::Bone || PendingDeltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	const float DeltaTime = PendingDeltaTime;
+	PendingDeltaTime = 0.0f;
+
+	// Bones missing from the current LOD hold the previous results
+	const FBoneContainer& BoneContainer = Output.Pose.GetBoneContainer();
+	if (!Bone.IsValidToEvaluate(BoneContainer))
+	{
+		return;
+	}
+
+	const FCompactPoseBoneIndex BoneIndex = Bone.GetCompactPoseIndex(BoneContainer);
+	FTransform Transform = Output.Pose[BoneIndex];
+	for (FCompactPoseBoneIndex ParentIndex = Output.Pose.GetParentBoneIndex(BoneIndex); ParentIndex.IsValid();
+	     ParentIndex = Output.Pose.GetParentBoneIndex(ParentIndex))
+	{
+		Transform *= Output.Pose[ParentIndex];
+	}
+
+	if (bWorldSpace)
+	{
+		Transform *= Output.AnimInstanceProxy->GetComponentTransform();
+	}
+
+	Sample(Transform, DeltaTime);
+}
+
+void FAnimNode_MotionIntensity::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("(Motion Intensity: %.3f)"), MotionIntensity);
+	DebugData.AddDebugItem(DebugLine);
+
+	Source.GatherDebugData(DebugData);
+}
+
+void FAnimNode_MotionIntensity::ResetMotionIntensity()
+{
+	ServiceData.Reset();
+	MotionData = FMotionIntensityMotionData();
+	MotionIntensity = 0.0f;
+	PendingDeltaTime = 0.0f;
+}
+
+/* Private methods */
+
+void FAnimNode_MotionIntensity::Sample(const FTransform& Transform, const float DeltaTime)
+{
+	static const FMotionIntensityConfig DefaultConfig;
+	static const FMotionIntensityCoefficients DefaultCoefficients;
+	const FMotionIntensityConfig& Config = Preset ? Preset->MotionIntensityConfig : DefaultConfig;
+	const FMotionIntensityCoefficients& Coefficients = Preset ? Preset->Coefficients : DefaultCoefficients;
+
+	if (!MotionIntensityValidation::ValidateConfig(Config) || !MotionIntensityValidation::ValidateCoefficients(Coefficients))
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_MotionIntensity_ObjectsEvaluated);
+	MotionData = MotionIntensityCore::CalculateMotionData<FMotionIntensityMotionData>(Transform.GetLocation(), Transform.GetRotation(), DeltaTime, Config, ServiceData);
+	MotionIntensity = MotionIntensityCore::GetMotionIntensityFromMotionData(MotionData, Coefficients);
+}
+
+/* Node functions */
+
+FMotionIntensityAnimNodeReference UMotionIntensityAnimNodeLibrary::ConvertToMotionIntensityNode(const FAnimNodeReference& Node,
+                                                                                                 EAnimNodeReferenceConversionResult& Result)
+{
+	return FAnimNodeReference::ConvertToType<FMotionIntensityAnimNodeReference>(Node, Result);
+}
+
+FMotionIntensityMotionData UMotionIntensityAnimNodeLibrary::GetAnimNodeMotionData(const FMotionIntensityAnimNodeReference& Node)
+{
+	FMotionIntensityMotionData MotionData;
+	Node.CallAnimNodeFunction<FAnimNode_MotionIntensity>(TEXT("GetAnimNodeMotionData"), [&MotionData](const FAnimNode_MotionIntensity& InNode)
+	{
+		MotionData = InNode.GetMotionData();
+	});
+	return MotionData;
+}
+
+float UMotionIntensityAnimNodeLibrary::GetAnimNodeMotionIntensity(const FMotionIntensityAnimNodeReference& Node)
+{
+	float MotionIntensity = 0.0f;
+	Node.CallAnimNodeFunction<FAnimNode_MotionIntensity>(TEXT("GetAnimNodeMotionIntensity"), [&MotionIntensity](const FAnimNode_MotionIntensity& InNode)
+	{
+		MotionIntensity = InNode.GetMotionIntensity();
+	});
+	return MotionIntensity;
+}
+
+void UMotionIntensityAnimNodeLibrary::ResetAnimNodeMotionIntensity(const FMotionIntensityAnimNodeReference& Node)
+{
+	Node.CallAnimNodeFunction<FAnimNode_MotionIntensity>(TEXT("ResetAnimNodeMotionIntensity"), [](FAnimNode_MotionIntensity& InNode)
+	{
+		InNode.ResetMotionIntensity();
+	});
+}
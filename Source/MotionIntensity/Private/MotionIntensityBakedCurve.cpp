@@ -0,0 +1,106 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityBakedCurve.h"
+#include "MotionIntensityTrack.h"
+#include "MotionIntensityValidation.h"
+
+/* Public methods */
+
+float UMotionIntensityBakedCurve::Evaluate(const float Time, const bool bLoop) const
+{
+	const int32 Number = NumSamples();
+	if (Number == 0)
+	{
+		return 0.0f;
+	}
+
+	float Position = FMath::Max(0.0f, Time * SampleRate);
+	if (bLoop && Number > 1)
+	{
+		// Wraps with the period of GetDuration(), the last sample is where the next loop starts
+		Position = FMath::Fmod(Position, static_cast<float>(Number - 1));
+	}
+
+	const int32 Index = FMath::Min(FMath::FloorToInt32(Position), Number - 1);
+	const int32 NextIndex = FMath::Min(Index + 1, Number - 1);
+	return FMath::Lerp(GetSample(Index), GetSample(NextIndex), Position - Index);
+}
+
+float UMotionIntensityBakedCurve::GetDuration() const
+{
+	return NumSamples() > 1 ? (NumSamples() - 1) / SampleRate : 0.0f;
+}
+
+bool UMotionIntensityBakedCurve::Bake(const TArray<FTransform>& Transforms,
+                                      const float InSampleRate,
+                                      const FMotionIntensityConfig& Config,
+                                      const FMotionIntensityCoefficients& Coefficients,
+                                      const EMotionIntensityQuantization InQuantization)
+{
+	if (InSampleRate <= 0.0f)
+	{
+		MotionIntensityValidation::ReportError(EMotionIntensityError::InvalidInput, TEXT("Sample rate should be larger than zero"));
+		return false;
+	}
+
+	TArray<float> MotionIntensities;
+	MotionIntensities.SetNumUninitialized(Transforms.Num());
+
+	FMotionIntensityTrackEvaluator Evaluator(Config, Coefficients);
+	if (!Evaluator.EvaluateTrack(Transforms, TArrayView<const float>(), InSampleRate, MotionIntensities))
+	{
+		return false;
+	}
+
+	SetSamples(MotionIntensities, InSampleRate, InQuantization);
+	return true;
+}
+
+void UMotionIntensityBakedCurve::SetSamples(const TArrayView<const float> MotionIntensities,
+                                            const float InSampleRate,
+                                            const EMotionIntensityQuantization InQuantization)
+{
+	check(InSampleRate > 0.0f);
+
+	SampleRate = InSampleRate;
+	Quantization = InQuantization;
+	EightBitSamples.Empty();
+	SixteenBitSamples.Empty();
+
+	Scale = 0.0f;
+	for (const float MotionIntensity : MotionIntensities)
+	{
+		Scale = FMath::Max(Scale, MotionIntensity);
+	}
+
+	const float MaxQuantized = Quantization == EMotionIntensityQuantization::EightBit ? MAX_uint8 : MAX_uint16;
+	const float QuantizationScale = Scale > 0.0f ? MaxQuantized / Scale : 0.0f;
+
+	if (Quantization == EMotionIntensityQuantization::EightBit)
+	{
+		EightBitSamples.SetNumUninitialized(MotionIntensities.Num());
+		for (int32 Index = 0; Index < MotionIntensities.Num(); ++Index)
+		{
+			EightBitSamples[Index] = static_cast<uint8>(FMath::RoundToInt32(FMath::Max(0.0f, MotionIntensities[Index]) * QuantizationScale));
+		}
+	}
+	else
+	{
+		SixteenBitSamples.SetNumUninitialized(MotionIntensities.Num());
+		for (int32 Index = 0; Index < MotionIntensities.Num(); ++Index)
+		{
+			SixteenBitSamples[Index] = static_cast<uint16>(FMath::RoundToInt32(FMath::Max(0.0f, MotionIntensities[Index]) * QuantizationScale));
+		}
+	}
+
+	MarkPackageDirty();
+}
+
+/* Private methods */
+
+float UMotionIntensityBakedCurve::GetSample(const int32 Index) const
+{
+	return Quantization == EMotionIntensityQuantization::EightBit
+		       ? EightBitSamples[Index] * (Scale / MAX_uint8)
+		       : SixteenBitSamples[Index] * (Scale / MAX_uint16);
+}
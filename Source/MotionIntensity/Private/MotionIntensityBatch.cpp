@@ -0,0 +1,804 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityBatch.h"
+#include "MotionIntensityBatchHistory.h"
+#include "MotionIntensityCoreAdapters.h"
+#include "MotionIntensityStats.h"
+#include "MotionIntensityValidation.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+
+static TAutoConsoleVariable<bool> CVarMotionIntensityBatchVectorized(
+	TEXT("MotionIntensity.Batch.Vectorized"),
+	true,
+	TEXT("If true, batches are evaluated four objects at a time with SIMD kernels, otherwise one object at a time."));
+
+static TAutoConsoleVariable<bool> CVarMotionIntensityBatchParallel(
+	TEXT("MotionIntensity.Batch.Parallel"),
+	true,
+	TEXT("If true, large batches are split into chunks that are evaluated on worker threads."));
+
+static TAutoConsoleVariable<int32> CVarMotionIntensityBatchMinParallelSize(
+	TEXT("MotionIntensity.Batch.MinParallelSize"),
+	2048,
+	TEXT("Batches with fewer objects than this are always evaluated on the calling thread."));
+
+static TAutoConsoleVariable<float> CVarMotionIntensityBatchMaxOriginDistance(
+	TEXT("MotionIntensity.Batch.MaxOriginDistance"),
+	50000.0f,
+	TEXT("Batches move their origin to the center of their objects once it's farther than this on any axis, in cm. ")
+	TEXT("Locations are stored in single precision relative to the origin, 0 keeps the origin where it is."));
+
+// Objects per parallel chunk. Multiple of the SIMD width and of the cache line size, so chunks never share a cache line
+// of the aligned state arrays, and chunk boundaries don't depend on the number of workers.
+static constexpr int32 MotionIntensityBatchChunkSize = 256;
+static_assert(MotionIntensityBatchChunkSize % MotionIntensityCore::Simd::Width == 0);
+static_assert(MotionIntensityBatchChunkSize % PLATFORM_CACHE_LINE_SIZE == 0);
+
+// State is stored in the core's compact layout, converted only when service data is copied in or out
+static FMotionIntensityFilterState ToFilterState(const MotionIntensityCore::FFilterState& State)
+{
+	FMotionIntensityFilterState Result;
+	Result.Z1 = State.Z1;
+	Result.Z2 = State.Z2;
+	Result.Z3 = State.Z3;
+	return Result;
+}
+
+static MotionIntensityCore::FFilterState ToFilterState(const FMotionIntensityFilterState& State)
+{
+	return {State.Z1, State.Z2, State.Z3};
+}
+
+static FVector ToVector(const MotionIntensityCore::FFloatVector3& Vector)
+{
+	return FVector(Vector.X, Vector.Y, Vector.Z);
+}
+
+static FQuat ToQuat(const MotionIntensityCore::FFloatQuat4& Quat)
+{
+	return FQuat(Quat.X, Quat.Y, Quat.Z, Quat.W);
+}
+
+template <typename ArrayType>
+static void SaveStateArray(const ArrayType& Array, uint8*& Destination)
+{
+	static_assert(std::is_trivially_copyable_v<typename ArrayType::ElementType>);
+
+	const int32 Size = Array.Num() * sizeof(typename ArrayType::ElementType);
+	FMemory::Memcpy(Destination, Array.GetData(), Size);
+	Destination += Size;
+}
+
+template <typename ArrayType>
+static void RestoreStateArray(ArrayType& Array, const int32 Number, const uint8*& Source)
+{
+	static_assert(std::is_trivially_copyable_v<typename ArrayType::ElementType>);
+
+	Array.SetNumUninitialized(Number);
+	const int32 Size = Number * sizeof(typename ArrayType::ElementType);
+	FMemory::Memcpy(Array.GetData(), Source, Size);
+	Source += Size;
+}
+
+/* Public methods */
+
+int32 FMotionIntensityBatch::Add()
+{
+	SetPreviousTransformToCurrent.Add(true);
+	PreviousLinearVelocities.Add(0.0f);
+	PreviousLinearAccelerations.Add(0.0f);
+	PreviousAngularVelocities.Add(0.0f);
+	PreviousAngularAccelerations.Add(0.0f);
+	if (OptionalState & FilterState)
+	{
+		LinearVelocityFilterStates.AddDefaulted();
+		LinearAccelerationFilterStates.AddDefaulted();
+		AngularVelocityFilterStates.AddDefaulted();
+		AngularAccelerationFilterStates.AddDefaulted();
+	}
+	if (OptionalState & FixedStepState)
+	{
+		TimeAccumulators.Add(0.0f);
+		FixedStepMotionData.AddDefaulted();
+	}
+	if (OptionalState & PreviousInputState)
+	{
+		PreviousInputLocations.AddDefaulted();
+		PreviousInputRotations.AddDefaulted();
+	}
+	PreviousRotations.AddDefaulted();
+	return PreviousLocations.AddDefaulted();
+}
+
+void FMotionIntensityBatch::RemoveAtSwap(const int32 Index)
+{
+	check(IsValidIndex(Index));
+
+	ForEachStateArray(*this, [Index](auto& Array)
+	{
+		Array.RemoveAtSwap(Index);
+	});
+}
+
+void FMotionIntensityBatch::ResetEntry(const int32 Index)
+{
+	check(IsValidIndex(Index));
+
+	ForEachStateArray(*this, [Index](auto& Array)
+	{
+		Array[Index] = typename std::decay_t<decltype(Array)>::ElementType();
+	});
+	SetPreviousTransformToCurrent[Index] = true;
+}
+
+void FMotionIntensityBatch::Empty()
+{
+	ForEachStateArray(*this, [](auto& Array)
+	{
+		Array.Empty();
+	});
+}
+
+void FMotionIntensityBatch::Reserve(const int32 Number)
+{
+	ForEachStateArray(*this, [Number](auto& Array)
+	{
+		Array.Reserve(Number);
+	});
+}
+
+void FMotionIntensityBatch::SetOrigin(const FVector& NewOrigin)
+{
+	for (MotionIntensityCore::FFloatVector3& PreviousLocation : PreviousLocations)
+	{
+		PreviousLocation = MotionIntensityCore::ToRelativeLocation(Origin + ToVector(PreviousLocation), NewOrigin);
+	}
+	for (MotionIntensityCore::FFloatVector3& PreviousInputLocation : PreviousInputLocations)
+	{
+		PreviousInputLocation = MotionIntensityCore::ToRelativeLocation(Origin + ToVector(PreviousInputLocation), NewOrigin);
+	}
+	Origin = NewOrigin;
+}
+
+void FMotionIntensityBatch::SaveSnapshot(FMotionIntensityBatchSnapshot& OutSnapshot) const
+{
+	OutSnapshot.Origin = Origin;
+	OutSnapshot.NumEntries = Num();
+	OutSnapshot.OptionalState = OptionalState;
+	OutSnapshot.Data.SetNumUninitialized(Num() * GetEntrySize(), EAllowShrinking::No);
+
+	uint8* Destination = OutSnapshot.Data.GetData();
+	ForEachStateArray(*this, [&Destination](const auto& Array)
+	{
+		SaveStateArray(Array, Destination);
+	});
+	check(Destination == OutSnapshot.Data.GetData() + OutSnapshot.Data.Num());
+}
+
+void FMotionIntensityBatch::RestoreSnapshot(const FMotionIntensityBatchSnapshot& Snapshot)
+{
+	const int32 Number = Snapshot.NumEntries;
+	Origin = Snapshot.Origin;
+
+	// State the snapshot doesn't have is dropped, it's allocated again once an evaluation needs it
+	ForEachOptionalStateArray(*this, OptionalState & ~Snapshot.OptionalState, [](auto& Array)
+	{
+		Array.Empty();
+	});
+	OptionalState = Snapshot.OptionalState;
+
+	const uint8* Source = Snapshot.Data.GetData();
+	ForEachStateArray(*this, [Number, &Source](auto& Array)
+	{
+		RestoreStateArray(Array, Number, Source);
+	});
+	check(Source == Snapshot.Data.GetData() + Snapshot.Data.Num());
+}
+
+FMotionIntensityServiceData FMotionIntensityBatch::GetServiceData(const int32 Index) const
+{
+	check(IsValidIndex(Index));
+
+	FMotionIntensityServiceData ServiceData;
+	ServiceData.bSetPreviousTransformToCurrent = SetPreviousTransformToCurrent[Index];
+	ServiceData.PreviousLocation = Origin + ToVector(PreviousLocations[Index]);
+	ServiceData.PreviousRotation = ToQuat(PreviousRotations[Index]);
+	ServiceData.PreviousLinearVelocity = PreviousLinearVelocities[Index];
+	ServiceData.PreviousLinearAcceleration = PreviousLinearAccelerations[Index];
+	ServiceData.PreviousAngularVelocity = PreviousAngularVelocities[Index];
+	ServiceData.PreviousAngularAcceleration = PreviousAngularAccelerations[Index];
+	if (OptionalState & FilterState)
+	{
+		ServiceData.LinearVelocityFilterState = ToFilterState(LinearVelocityFilterStates[Index]);
+		ServiceData.LinearAccelerationFilterState = ToFilterState(LinearAccelerationFilterStates[Index]);
+		ServiceData.AngularVelocityFilterState = ToFilterState(AngularVelocityFilterStates[Index]);
+		ServiceData.AngularAccelerationFilterState = ToFilterState(AngularAccelerationFilterStates[Index]);
+	}
+	if (OptionalState & FixedStepState)
+	{
+		ServiceData.TimeAccumulator = TimeAccumulators[Index];
+		ServiceData.FixedStepMotionData = MotionIntensityCore::UnpackMotionData<FMotionIntensityMotionData>(FixedStepMotionData[Index]);
+	}
+	return ServiceData;
+}
+
+void FMotionIntensityBatch::SetServiceData(const int32 Index, const FMotionIntensityServiceData& ServiceData)
+{
+	check(IsValidIndex(Index));
+
+	SetPreviousTransformToCurrent[Index] = ServiceData.bSetPreviousTransformToCurrent;
+	PreviousLocations[Index] = MotionIntensityCore::ToRelativeLocation(ServiceData.PreviousLocation, Origin);
+	PreviousRotations[Index] = MotionIntensityCore::ToFloatRotation(ServiceData.PreviousRotation);
+	PreviousLinearVelocities[Index] = ServiceData.PreviousLinearVelocity;
+	PreviousLinearAccelerations[Index] = ServiceData.PreviousLinearAcceleration;
+	PreviousAngularVelocities[Index] = ServiceData.PreviousAngularVelocity;
+	PreviousAngularAccelerations[Index] = ServiceData.PreviousAngularAcceleration;
+	if (OptionalState & FilterState)
+	{
+		LinearVelocityFilterStates[Index] = ToFilterState(ServiceData.LinearVelocityFilterState);
+		LinearAccelerationFilterStates[Index] = ToFilterState(ServiceData.LinearAccelerationFilterState);
+		AngularVelocityFilterStates[Index] = ToFilterState(ServiceData.AngularVelocityFilterState);
+		AngularAccelerationFilterStates[Index] = ToFilterState(ServiceData.AngularAccelerationFilterState);
+	}
+	if (OptionalState & FixedStepState)
+	{
+		TimeAccumulators[Index] = ServiceData.TimeAccumulator;
+		FixedStepMotionData[Index] = MotionIntensityCore::PackMotionData(ServiceData.FixedStepMotionData);
+	}
+
+	// Service Data doesn't keep the last input, indexed evaluation continues from the smoothed transform instead
+	if (OptionalState & PreviousInputState)
+	{
+		PreviousInputLocations[Index] = PreviousLocations[Index];
+		PreviousInputRotations[Index] = PreviousRotations[Index];
+	}
+}
+
+bool FMotionIntensityBatch::CalculateMotionData(const TArrayView<const FVector> Locations,
+                                                const TArrayView<const FQuat> Rotations,
+                                                const float DeltaTime,
+                                                const FMotionIntensityConfig& Config,
+                                                const TArrayView<FMotionIntensityMotionData> OutMotionData)
+{
+	check(OutMotionData.Num() == Num());
+
+	if (!ValidateInputs(DeltaTime, Config))
+	{
+		return false;
+	}
+
+	Evaluate(Locations, Rotations, DeltaTime, Config,
+	         [&OutMotionData](const int32 Index, const MotionIntensityCore::FPackedMotionData& MotionData)
+	         {
+		         OutMotionData[Index] = MotionIntensityCore::UnpackMotionData<FMotionIntensityMotionData>(MotionData);
+	         });
+	return true;
+}
+
+bool FMotionIntensityBatch::GetMotionIntensity(const TArrayView<const FVector> Locations,
+                                               const TArrayView<const FQuat> Rotations,
+                                               const float DeltaTime,
+                                               const FMotionIntensityConfig& Config,
+                                               const FMotionIntensityCoefficients& Coefficients,
+                                               const TArrayView<float> OutMotionIntensities)
+{
+	if (!MotionIntensityValidation::ValidateCoefficients(Coefficients))
+	{
+		return false;
+	}
+
+	return GetMotionIntensity(Locations, Rotations, DeltaTime, Config, FMotionIntensityCompiledCoefficients(Coefficients), OutMotionIntensities);
+}
+
+bool FMotionIntensityBatch::GetMotionIntensity(const TArrayView<const FVector> Locations,
+                                               const TArrayView<const FQuat> Rotations,
+                                               const float DeltaTime,
+                                               const FMotionIntensityConfig& Config,
+                                               const FMotionIntensityCoefficients& Coefficients,
+                                               const TArrayView<FMotionIntensityMotionData> OutMotionData,
+                                               const TArrayView<float> OutMotionIntensities)
+{
+	if (!MotionIntensityValidation::ValidateCoefficients(Coefficients))
+	{
+		return false;
+	}
+
+	return GetMotionIntensity(Locations, Rotations, DeltaTime, Config, FMotionIntensityCompiledCoefficients(Coefficients), OutMotionData, OutMotionIntensities);
+}
+
+bool FMotionIntensityBatch::GetMotionIntensity(const TArrayView<const FVector> Locations,
+                                               const TArrayView<const FQuat> Rotations,
+                                               const float DeltaTime,
+                                               const FMotionIntensityConfig& Config,
+                                               const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+                                               const TArrayView<float> OutMotionIntensities)
+{
+	check(OutMotionIntensities.Num() == Num());
+
+	if (!ValidateInputs(DeltaTime, Config))
+	{
+		return false;
+	}
+
+	if (!MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients))
+	{
+		return false;
+	}
+
+	Evaluate(Locations, Rotations, DeltaTime, Config,
+	         [&OutMotionIntensities, &CompiledCoefficients](const int32 Index, const MotionIntensityCore::FPackedMotionData& MotionData)
+	         {
+		         OutMotionIntensities[Index] = CompiledCoefficients.GetMotionIntensity(MotionData);
+	         });
+	return true;
+}
+
+bool FMotionIntensityBatch::GetMotionIntensity(const TArrayView<const FVector> Locations,
+                                               const TArrayView<const FQuat> Rotations,
+                                               const float DeltaTime,
+                                               const FMotionIntensityConfig& Config,
+                                               const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+                                               const TArrayView<FMotionIntensityMotionData> OutMotionData,
+                                               const TArrayView<float> OutMotionIntensities)
+{
+	check(OutMotionData.Num() == Num() && OutMotionIntensities.Num() == Num());
+
+	if (!ValidateInputs(DeltaTime, Config))
+	{
+		return false;
+	}
+
+	if (!MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients))
+	{
+		return false;
+	}
+
+	Evaluate(Locations, Rotations, DeltaTime, Config,
+	         [&OutMotionData, &OutMotionIntensities, &CompiledCoefficients](const int32 Index, const MotionIntensityCore::FPackedMotionData& MotionData)
+	         {
+		         OutMotionData[Index] = MotionIntensityCore::UnpackMotionData<FMotionIntensityMotionData>(MotionData);
+		         OutMotionIntensities[Index] = CompiledCoefficients.GetMotionIntensity(MotionData);
+	         });
+	return true;
+}
+
+bool FMotionIntensityBatch::CalculateMotionDataFromVelocity(const TArrayView<const FVector> LinearVelocities,
+                                                            const TArrayView<const FVector> AngularVelocities,
+                                                            const float DeltaTime,
+                                                            const FMotionIntensityConfig& Config,
+                                                            const TArrayView<FMotionIntensityMotionData> OutMotionData)
+{
+	check(OutMotionData.Num() == Num());
+
+	if (!ValidateInputs(DeltaTime, Config))
+	{
+		return false;
+	}
+
+	EvaluateFromVelocity(LinearVelocities, AngularVelocities, DeltaTime, Config,
+	                     [&OutMotionData](const int32 Index, const MotionIntensityCore::FPackedMotionData& MotionData)
+	                     {
+		                     OutMotionData[Index] = MotionIntensityCore::UnpackMotionData<FMotionIntensityMotionData>(MotionData);
+	                     });
+	return true;
+}
+
+bool FMotionIntensityBatch::GetMotionIntensityFromVelocity(const TArrayView<const FVector> LinearVelocities,
+                                                           const TArrayView<const FVector> AngularVelocities,
+                                                           const float DeltaTime,
+                                                           const FMotionIntensityConfig& Config,
+                                                           const FMotionIntensityCoefficients& Coefficients,
+                                                           const TArrayView<FMotionIntensityMotionData> OutMotionData,
+                                                           const TArrayView<float> OutMotionIntensities)
+{
+	if (!MotionIntensityValidation::ValidateCoefficients(Coefficients))
+	{
+		return false;
+	}
+
+	return GetMotionIntensityFromVelocity(LinearVelocities, AngularVelocities, DeltaTime, Config, FMotionIntensityCompiledCoefficients(Coefficients), OutMotionData, OutMotionIntensities);
+}
+
+bool FMotionIntensityBatch::GetMotionIntensityFromVelocity(const TArrayView<const FVector> LinearVelocities,
+                                                           const TArrayView<const FVector> AngularVelocities,
+                                                           const float DeltaTime,
+                                                           const FMotionIntensityConfig& Config,
+                                                           const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+                                                           const TArrayView<FMotionIntensityMotionData> OutMotionData,
+                                                           const TArrayView<float> OutMotionIntensities)
+{
+	check((OutMotionData.Num() == 0 || OutMotionData.Num() == Num()) && OutMotionIntensities.Num() == Num());
+
+	if (!ValidateInputs(DeltaTime, Config))
+	{
+		return false;
+	}
+
+	if (!MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients))
+	{
+		return false;
+	}
+
+	EvaluateFromVelocity(LinearVelocities, AngularVelocities, DeltaTime, Config,
+	                     [&OutMotionData, &OutMotionIntensities, &CompiledCoefficients](const int32 Index, const MotionIntensityCore::FPackedMotionData& MotionData)
+	                     {
+		                     if (OutMotionData.Num() > 0)
+		                     {
+			                     OutMotionData[Index] = MotionIntensityCore::UnpackMotionData<FMotionIntensityMotionData>(MotionData);
+		                     }
+		                     OutMotionIntensities[Index] = CompiledCoefficients.GetMotionIntensity(MotionData);
+	                     });
+	return true;
+}
+
+bool FMotionIntensityBatch::GetMotionIntensity(const TArrayView<const int32> Indices,
+                                               const TArrayView<const FVector> Locations,
+                                               const TArrayView<const FQuat> Rotations,
+                                               const TArrayView<const float> DeltaTimes,
+                                               const TArrayView<const int32> Frames,
+                                               const FMotionIntensityConfig& Config,
+                                               const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+                                               const TArrayView<FMotionIntensityMotionData> OutMotionData,
+                                               const TArrayView<float> OutMotionIntensities)
+{
+	check(Locations.Num() == Num() && Rotations.Num() == Num() && DeltaTimes.Num() == Num() && Frames.Num() == Num());
+	check(OutMotionData.Num() == Num() && OutMotionIntensities.Num() == Num());
+
+	if (!ValidateIndexedInputs(Indices, DeltaTimes, Frames, Config) || !MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients))
+	{
+		return false;
+	}
+
+	AllocateState(Config, PreviousInputState);
+	FollowLocations(Indices.Num(), [&Indices, &Locations](const int32 Position) { return Locations[Indices[Position]]; });
+
+	const MotionIntensityCore::TBatchView<FVector, FQuat> View = GetView();
+	auto OutputFunction = [&OutMotionData, &OutMotionIntensities, &CompiledCoefficients](const int32 Index, const MotionIntensityCore::FPackedMotionData& MotionData)
+	{
+		OutMotionData[Index] = MotionIntensityCore::UnpackMotionData<FMotionIntensityMotionData>(MotionData);
+		OutMotionIntensities[Index] = CompiledCoefficients.GetMotionIntensity(MotionData);
+	};
+
+	// Listed entries are distinct, so chunks of the list never share an entry
+	EvaluateRanges(Indices.Num(), [&](const int32 Begin, const int32 End)
+	{
+		MotionIntensityCore::EvaluateIndices(View,
+		                                     Indices.GetData() + Begin,
+		                                     End - Begin,
+		                                     Locations.GetData(),
+		                                     Rotations.GetData(),
+		                                     DeltaTimes.GetData(),
+		                                     Frames.GetData(),
+		                                     Config,
+		                                     OutputFunction);
+	});
+	return true;
+}
+
+bool FMotionIntensityBatch::Resimulate(const TArrayView<const FVector> Locations,
+                                       const TArrayView<const FQuat> Rotations,
+                                       const TArrayView<const float> DeltaTimes,
+                                       const FMotionIntensityConfig& Config,
+                                       const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+                                       const TArrayView<FMotionIntensityMotionData> OutMotionData,
+                                       const TArrayView<float> OutMotionIntensities)
+{
+	const int32 Number = Num();
+	const int32 NumFrames = DeltaTimes.Num();
+	check(Locations.Num() == Number * NumFrames && Rotations.Num() == Number * NumFrames);
+	check(OutMotionData.Num() == Number && OutMotionIntensities.Num() == Number);
+
+	for (const float DeltaTime : DeltaTimes)
+	{
+		if (!MotionIntensityValidation::ValidateDeltaTime(DeltaTime))
+		{
+			return false;
+		}
+	}
+
+	if (!MotionIntensityValidation::ValidateConfig(Config) || !MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients))
+	{
+		return false;
+	}
+
+	if (NumFrames == 0)
+	{
+		return true;
+	}
+
+	AllocateState(Config);
+	FollowLocations(Number, [&Locations](const int32 Index) { return Locations[Index]; });
+
+	const MotionIntensityCore::TBatchView<FVector, FQuat> View = GetView();
+	const bool bVectorized = CVarMotionIntensityBatchVectorized.GetValueOnAnyThread();
+	auto SkipOutputFunction = [](int32, const MotionIntensityCore::FPackedMotionData&)
+	{
+	};
+	auto OutputFunction = [&OutMotionData, &OutMotionIntensities, &CompiledCoefficients](const int32 Index, const MotionIntensityCore::FPackedMotionData& MotionData)
+	{
+		OutMotionData[Index] = MotionIntensityCore::UnpackMotionData<FMotionIntensityMotionData>(MotionData);
+		OutMotionIntensities[Index] = CompiledCoefficients.GetMotionIntensity(MotionData);
+	};
+
+	// Ranges are counted once, the frames before the last one are the rest of the work
+	INC_DWORD_STAT_BY(STAT_MotionIntensity_ObjectsEvaluated, Number * (NumFrames - 1));
+
+	EvaluateRanges(Number, [&](const int32 Begin, const int32 End)
+	{
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const FVector* FrameLocations = Locations.GetData() + Frame * Number;
+			const FQuat* FrameRotations = Rotations.GetData() + Frame * Number;
+			if (Frame + 1 < NumFrames)
+			{
+				MotionIntensityCore::EvaluateRange(View, Begin, End, FrameLocations, FrameRotations, DeltaTimes[Frame], Config, bVectorized, SkipOutputFunction);
+			}
+			else
+			{
+				MotionIntensityCore::EvaluateRange(View, Begin, End, FrameLocations, FrameRotations, DeltaTimes[Frame], Config, bVectorized, OutputFunction);
+			}
+		}
+	});
+	return true;
+}
+
+/* Private methods */
+
+void FMotionIntensityBatch::AllocateState(const FMotionIntensityConfig& Config, uint8 State)
+{
+	const bool bFilterHasState = MotionIntensityCore::DispatchFilter(Config, [](auto Filter)
+	{
+		return decltype(Filter)::bHasState;
+	});
+	State |= (bFilterHasState ? FilterState : 0) | (Config.bUseFixedTimeStep ? FixedStepState : 0);
+
+	const uint8 NewState = State & ~OptionalState;
+	if (NewState == 0)
+	{
+		return;
+	}
+
+	const int32 Number = Num();
+	if (NewState & FilterState)
+	{
+		LinearVelocityFilterStates.SetNumZeroed(Number);
+		LinearAccelerationFilterStates.SetNumZeroed(Number);
+		AngularVelocityFilterStates.SetNumZeroed(Number);
+		AngularAccelerationFilterStates.SetNumZeroed(Number);
+
+		// Entries continue from their smoothed values as if the filter had been running all along
+		MotionIntensityCore::DispatchFilter(Config, [&](auto Filter)
+		{
+			using FilterType = decltype(Filter);
+			for (int32 Index = 0; Index < Number; ++Index)
+			{
+				FilterType::Settle(PreviousLinearVelocities[Index], PreviousLinearVelocities[Index], LinearVelocityFilterStates[Index]);
+				FilterType::Settle(PreviousLinearAccelerations[Index], PreviousLinearAccelerations[Index], LinearAccelerationFilterStates[Index]);
+				FilterType::Settle(PreviousAngularVelocities[Index], PreviousAngularVelocities[Index], AngularVelocityFilterStates[Index]);
+				FilterType::Settle(PreviousAngularAccelerations[Index], PreviousAngularAccelerations[Index], AngularAccelerationFilterStates[Index]);
+			}
+		});
+	}
+	if (NewState & FixedStepState)
+	{
+		TimeAccumulators.SetNumZeroed(Number);
+		FixedStepMotionData.SetNumZeroed(Number);
+	}
+	if (NewState & PreviousInputState)
+	{
+		PreviousInputLocations = PreviousLocations;
+		PreviousInputRotations = PreviousRotations;
+	}
+
+	OptionalState |= NewState;
+}
+
+template <typename BatchType, typename FunctionType>
+void FMotionIntensityBatch::ForEachStateArray(BatchType& Batch, FunctionType&& Function)
+{
+	Function(Batch.SetPreviousTransformToCurrent);
+	Function(Batch.PreviousLocations);
+	Function(Batch.PreviousRotations);
+	Function(Batch.PreviousLinearVelocities);
+	Function(Batch.PreviousLinearAccelerations);
+	Function(Batch.PreviousAngularVelocities);
+	Function(Batch.PreviousAngularAccelerations);
+	ForEachOptionalStateArray(Batch, Batch.OptionalState, Function);
+}
+
+template <typename BatchType, typename FunctionType>
+void FMotionIntensityBatch::ForEachOptionalStateArray(BatchType& Batch, const uint8 State, FunctionType&& Function)
+{
+	if (State & FilterState)
+	{
+		Function(Batch.LinearVelocityFilterStates);
+		Function(Batch.LinearAccelerationFilterStates);
+		Function(Batch.AngularVelocityFilterStates);
+		Function(Batch.AngularAccelerationFilterStates);
+	}
+	if (State & FixedStepState)
+	{
+		Function(Batch.TimeAccumulators);
+		Function(Batch.FixedStepMotionData);
+	}
+	if (State & PreviousInputState)
+	{
+		Function(Batch.PreviousInputLocations);
+		Function(Batch.PreviousInputRotations);
+	}
+}
+
+int32 FMotionIntensityBatch::GetEntrySize() const
+{
+	int32 EntrySize = 0;
+	ForEachStateArray(*this, [&EntrySize](const auto& Array)
+	{
+		EntrySize += sizeof(typename std::decay_t<decltype(Array)>::ElementType);
+	});
+	return EntrySize;
+}
+
+bool FMotionIntensityBatch::ValidateInputs(const float DeltaTime, const FMotionIntensityConfig& Config)
+{
+	if (!MotionIntensityValidation::ValidateDeltaTime(DeltaTime))
+	{
+		return false;
+	}
+
+	if (!MotionIntensityValidation::ValidateConfig(Config))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool FMotionIntensityBatch::ValidateIndexedInputs(const TArrayView<const int32> Indices,
+                                                  const TArrayView<const float> DeltaTimes,
+                                                  const TArrayView<const int32> Frames,
+                                                  const FMotionIntensityConfig& Config) const
+{
+	for (const int32 Index : Indices)
+	{
+		check(IsValidIndex(Index));
+
+		if (!MotionIntensityValidation::ValidateDeltaTime(DeltaTimes[Index]))
+		{
+			return false;
+		}
+
+		if (UNLIKELY(Frames[Index] <= 0))
+		{
+			MotionIntensityValidation::ReportError(EMotionIntensityError::InvalidInput, TEXT("Every listed entry should cover at least one frame"));
+			return false;
+		}
+	}
+
+	return MotionIntensityValidation::ValidateConfig(Config);
+}
+
+MotionIntensityCore::TBatchView<FVector, FQuat> FMotionIntensityBatch::GetView()
+{
+	MotionIntensityCore::TBatchView<FVector, FQuat> View;
+	View.Origin = Origin;
+	View.SetPreviousTransformToCurrent = SetPreviousTransformToCurrent.GetData();
+	View.PreviousLocations = PreviousLocations.GetData();
+	View.PreviousRotations = PreviousRotations.GetData();
+	View.PreviousLinearVelocities = PreviousLinearVelocities.GetData();
+	View.PreviousLinearAccelerations = PreviousLinearAccelerations.GetData();
+	View.PreviousAngularVelocities = PreviousAngularVelocities.GetData();
+	View.PreviousAngularAccelerations = PreviousAngularAccelerations.GetData();
+	View.LinearVelocityFilterStates = LinearVelocityFilterStates.GetData();
+	View.LinearAccelerationFilterStates = LinearAccelerationFilterStates.GetData();
+	View.AngularVelocityFilterStates = AngularVelocityFilterStates.GetData();
+	View.AngularAccelerationFilterStates = AngularAccelerationFilterStates.GetData();
+	View.TimeAccumulators = TimeAccumulators.GetData();
+	View.FixedStepMotionData = FixedStepMotionData.GetData();
+	View.PreviousInputLocations = PreviousInputLocations.GetData();
+	View.PreviousInputRotations = PreviousInputRotations.GetData();
+	return View;
+}
+
+template <typename OutputFunctionType>
+void FMotionIntensityBatch::Evaluate(const TArrayView<const FVector> Locations,
+                                     const TArrayView<const FQuat> Rotations,
+                                     const float DeltaTime,
+                                     const FMotionIntensityConfig& Config,
+                                     OutputFunctionType&& OutputFunction)
+{
+	check(Locations.Num() == Num() && Rotations.Num() == Num());
+
+	AllocateState(Config);
+	FollowLocations(Num(), [&Locations](const int32 Index) { return Locations[Index]; });
+
+	const MotionIntensityCore::TBatchView<FVector, FQuat> View = GetView();
+	const bool bVectorized = CVarMotionIntensityBatchVectorized.GetValueOnAnyThread();
+
+	EvaluateRanges(Num(), [&](const int32 Begin, const int32 End)
+	{
+		MotionIntensityCore::EvaluateRange(View,
+		                                   Begin,
+		                                   End,
+		                                   Locations.GetData(),
+		                                   Rotations.GetData(),
+		                                   DeltaTime,
+		                                   Config,
+		                                   bVectorized,
+		                                   OutputFunction);
+	});
+}
+
+template <typename OutputFunctionType>
+void FMotionIntensityBatch::EvaluateFromVelocity(const TArrayView<const FVector> LinearVelocities,
+                                                 const TArrayView<const FVector> AngularVelocities,
+                                                 const float DeltaTime,
+                                                 const FMotionIntensityConfig& Config,
+                                                 OutputFunctionType&& OutputFunction)
+{
+	check(LinearVelocities.Num() == Num() && AngularVelocities.Num() == Num());
+
+	AllocateState(Config);
+	const MotionIntensityCore::TBatchView<FVector, FQuat> View = GetView();
+
+	EvaluateRanges(Num(), [&](const int32 Begin, const int32 End)
+	{
+		MotionIntensityCore::EvaluateRangeFromVelocity(View,
+		                                               Begin,
+		                                               End,
+		                                               LinearVelocities.GetData(),
+		                                               AngularVelocities.GetData(),
+		                                               DeltaTime,
+		                                               Config,
+		                                               OutputFunction);
+	});
+}
+
+template <typename LocationFunctionType>
+void FMotionIntensityBatch::FollowLocations(const int32 Number, LocationFunctionType&& GetLocation)
+{
+	const double MaxOriginDistance = CVarMotionIntensityBatchMaxOriginDistance.GetValueOnAnyThread();
+	if (Number == 0 || MaxOriginDistance <= 0.0)
+	{
+		return;
+	}
+
+	FBox Bounds(ForceInit);
+	for (int32 Index = 0; Index < Number; ++Index)
+	{
+		Bounds += GetLocation(Index);
+	}
+
+	// The center of a batch spread over the world doesn't move, so it doesn't rebase every frame
+	const FVector Center = Bounds.GetCenter();
+	if ((Center - Origin).GetAbsMax() > MaxOriginDistance)
+	{
+		INC_DWORD_STAT(STAT_MotionIntensity_OriginRebases);
+		SetOrigin(Center);
+	}
+}
+
+template <typename RangeFunctionType>
+void FMotionIntensityBatch::EvaluateRanges(const int32 Number, RangeFunctionType&& RangeFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_BatchEvaluate);
+
+	INC_DWORD_STAT_BY(STAT_MotionIntensity_ObjectsEvaluated, Number);
+
+	if (CVarMotionIntensityBatchParallel.GetValueOnAnyThread()
+		&& Number >= FMath::Max(CVarMotionIntensityBatchMinParallelSize.GetValueOnAnyThread(), MotionIntensityBatchChunkSize * 2))
+	{
+		// Every object only touches its own state, so results don't depend on how chunks are scheduled
+		const int32 NumChunks = FMath::DivideAndRoundUp(Number, MotionIntensityBatchChunkSize);
+		ParallelFor(NumChunks, [&](const int32 Chunk)
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(MotionIntensityBatchChunk);
+			const int32 Begin = Chunk * MotionIntensityBatchChunkSize;
+			RangeFunction(Begin, FMath::Min(Begin + MotionIntensityBatchChunkSize, Number));
+		});
+	}
+	else
+	{
+		RangeFunction(0, Number);
+	}
+}
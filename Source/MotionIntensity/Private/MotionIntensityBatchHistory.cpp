@@ -0,0 +1,69 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityBatchHistory.h"
+
+FMotionIntensityBatchHistory::FMotionIntensityBatchHistory(const int32 InDepth)
+{
+	SetDepth(InDepth);
+}
+
+/* Public methods */
+
+void FMotionIntensityBatchHistory::SetDepth(const int32 NewDepth)
+{
+	check(NewDepth > 0);
+
+	Snapshots.SetNum(NewDepth);
+	Frames.Init(INDEX_NONE, NewDepth);
+}
+
+void FMotionIntensityBatchHistory::Record(const FMotionIntensityBatch& Batch, const int32 Frame)
+{
+	check(Frame >= 0);
+
+	const int32 Slot = Frame % GetDepth();
+	Batch.SaveSnapshot(Snapshots[Slot]);
+	Frames[Slot] = Frame;
+}
+
+const FMotionIntensityBatchSnapshot* FMotionIntensityBatchHistory::Find(const int32 Frame) const
+{
+	if (Frame < 0)
+	{
+		return nullptr;
+	}
+
+	const int32 Slot = Frame % GetDepth();
+	return Frames[Slot] == Frame ? &Snapshots[Slot] : nullptr;
+}
+
+bool FMotionIntensityBatchHistory::Restore(FMotionIntensityBatch& Batch, const int32 Frame) const
+{
+	const FMotionIntensityBatchSnapshot* Snapshot = Find(Frame);
+	if (!Snapshot)
+	{
+		return false;
+	}
+
+	Batch.RestoreSnapshot(*Snapshot);
+	return true;
+}
+
+void FMotionIntensityBatchHistory::DiscardAfter(const int32 Frame)
+{
+	for (int32& SlotFrame : Frames)
+	{
+		if (SlotFrame > Frame)
+		{
+			SlotFrame = INDEX_NONE;
+		}
+	}
+}
+
+void FMotionIntensityBatchHistory::Empty()
+{
+	for (int32& SlotFrame : Frames)
+	{
+		SlotFrame = INDEX_NONE;
+	}
+}
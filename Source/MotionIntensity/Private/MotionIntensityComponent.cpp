@@ -0,0 +1,193 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityComponent.h"
+#include "MotionIntensitySubsystem.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Net/UnrealNetwork.h"
+
+UMotionIntensityComponent::UMotionIntensityComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UMotionIntensityComponent::SetPreset(UMotionIntensityPreset* NewPreset)
+{
+	if (Preset == NewPreset)
+	{
+		return;
+	}
+
+	const bool bWasRegistered = IsRegisteredWithSubsystem();
+	UnregisterFromSubsystem();
+	Preset = NewPreset;
+	if (bWasRegistered)
+	{
+		RegisterWithSubsystem();
+	}
+}
+
+void UMotionIntensityComponent::SetTrackedComponent(USceneComponent* NewTrackedComponent)
+{
+	TrackedComponent = NewTrackedComponent;
+
+	// Physics thread evaluation is bound to the body, so the new one has to be registered
+	if (PhysicsEntryIndex != INDEX_NONE)
+	{
+		UnregisterFromSubsystem();
+		RegisterWithSubsystem();
+	}
+	ResetMotionIntensity();
+}
+
+USceneComponent* UMotionIntensityComponent::GetTrackedComponent() const
+{
+	if (TrackedComponent)
+	{
+		return TrackedComponent;
+	}
+
+	const AActor* Owner = GetOwner();
+	return Owner ? Owner->GetRootComponent() : nullptr;
+}
+
+void UMotionIntensityComponent::ResetMotionIntensity()
+{
+	MotionData = FMotionIntensityMotionData();
+	MotionIntensity = 0.0f;
+
+	if (IsRegisteredWithSubsystem())
+	{
+		if (UMotionIntensitySubsystem* Subsystem = UWorld::GetSubsystem<UMotionIntensitySubsystem>(GetWorld()))
+		{
+			Subsystem->ResetComponent(this);
+		}
+	}
+}
+
+bool UMotionIntensityComponent::IsThresholdActive(const FName ThresholdName) const
+{
+	const FMotionIntensityThreshold* Threshold = Thresholds.FindByPredicate([ThresholdName](const FMotionIntensityThreshold& Candidate)
+	{
+		return Candidate.Name == ThresholdName;
+	});
+	return Threshold && Threshold->IsActive();
+}
+
+void UMotionIntensityComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UMotionIntensityComponent, ReplicatedMotionIntensity);
+}
+
+void UMotionIntensityComponent::BeginPlay()
+{
+	if (bReplicateMotionIntensity)
+	{
+		SetIsReplicated(true);
+	}
+
+	Super::BeginPlay();
+	RegisterWithSubsystem();
+}
+
+void UMotionIntensityComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromSubsystem();
+	Super::EndPlay(EndPlayReason);
+}
+
+void UMotionIntensityComponent::RegisterWithSubsystem()
+{
+	if (UMotionIntensitySubsystem* Subsystem = UWorld::GetSubsystem<UMotionIntensitySubsystem>(GetWorld()))
+	{
+		Subsystem->RegisterComponent(this);
+	}
+}
+
+void UMotionIntensityComponent::UnregisterFromSubsystem()
+{
+	if (!IsRegisteredWithSubsystem())
+	{
+		return;
+	}
+
+	if (UMotionIntensitySubsystem* Subsystem = UWorld::GetSubsystem<UMotionIntensitySubsystem>(GetWorld()))
+	{
+		Subsystem->UnregisterComponent(this);
+	}
+}
+
+void UMotionIntensityComponent::TraceMotionIntensity()
+{
+#if COUNTERSTRACE_ENABLED
+	if (!TraceCounter)
+	{
+		TraceCounterName = FString::Printf(TEXT("MotionIntensity/%s"), *GetPathName(GetWorld()));
+		TraceCounter = MakeUnique<FCountersTrace::FCounterFloat>(*TraceCounterName, TraceCounterDisplayHint_None);
+	}
+	TraceCounter->Set(MotionIntensity);
+#endif
+}
+
+void UMotionIntensityComponent::UpdateReplicatedMotionIntensity()
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		ReplicatedMotionIntensity.Update(MotionData, MotionIntensity, ReplicationThreshold);
+	}
+}
+
+bool UMotionIntensityComponent::UpdateThresholds(const float DeltaTime)
+{
+	for (int32 Index = 0; Index < Thresholds.Num(); ++Index)
+	{
+		if (Thresholds[Index].Update(MotionData, MotionIntensity, DeltaTime))
+		{
+			PendingThresholdChanges.Add(Index);
+		}
+	}
+	return PendingThresholdChanges.Num() > 0;
+}
+
+void UMotionIntensityComponent::BroadcastThresholdEvents()
+{
+	// Handlers may edit the thresholds, so the events are taken over first
+	const TArray<int32, TInlineAllocator<4>> Changes = MoveTemp(PendingThresholdChanges);
+	PendingThresholdChanges.Reset();
+
+	// Components are updated once per frame, so every threshold is listed at most once and its state is the new one
+	for (const int32 Index : Changes)
+	{
+		if (!Thresholds.IsValidIndex(Index))
+		{
+			continue;
+		}
+
+		const FName ThresholdName = Thresholds[Index].Name;
+		if (Thresholds[Index].IsActive())
+		{
+			OnThresholdEntered.Broadcast(ThresholdName);
+		}
+		else
+		{
+			OnThresholdExited.Broadcast(ThresholdName);
+		}
+	}
+}
+
+void UMotionIntensityComponent::OnRep_ReplicatedMotionIntensity()
+{
+	MotionData = ReplicatedMotionIntensity.GetMotionData();
+	MotionIntensity = ReplicatedMotionIntensity.GetMotionIntensity();
+
+	if (GroupIndex != INDEX_NONE)
+	{
+		if (UMotionIntensitySubsystem* Subsystem = UWorld::GetSubsystem<UMotionIntensitySubsystem>(GetWorld()))
+		{
+			Subsystem->ApplyReplicatedData(this, ReplicatedMotionIntensity);
+		}
+	}
+}
@@ -0,0 +1,113 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityPhysics.h"
+#include "MotionIntensityCoreAdapters.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+
+/* Public methods */
+
+uint32 FMotionIntensityPhysicsCallback::AddBody(FSingleParticlePhysicsProxy* Proxy,
+                                                const FMotionIntensityConfig& Config,
+                                                const FMotionIntensityCoefficients& Coefficients,
+                                                TSharedPtr<FMotionIntensityPhysicsOutput, ESPMode::ThreadSafe>& OutOutput)
+{
+	check(IsInGameThread());
+	check(Proxy);
+
+	OutOutput = MakeShared<FMotionIntensityPhysicsOutput, ESPMode::ThreadSafe>();
+
+	FMotionIntensityPhysicsInput::FAddedBody& AddedBody = GetProducerInputData_External()->AddedBodies.AddDefaulted_GetRef();
+	AddedBody.Id = NextId++;
+	AddedBody.Proxy = Proxy;
+	AddedBody.Config = Config;
+	AddedBody.Coefficients = FMotionIntensityCompiledCoefficients(Coefficients);
+	AddedBody.Output = OutOutput;
+	return AddedBody.Id;
+}
+
+void FMotionIntensityPhysicsCallback::RemoveBody(const uint32 Id)
+{
+	check(IsInGameThread());
+	GetProducerInputData_External()->RemovedBodies.Add(Id);
+}
+
+void FMotionIntensityPhysicsCallback::ResetBody(const uint32 Id)
+{
+	check(IsInGameThread());
+	GetProducerInputData_External()->ResetBodies.Add(Id);
+}
+
+/* Private methods */
+
+void FMotionIntensityPhysicsCallback::OnPreSimulate_Internal()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FMotionIntensityPhysicsCallback::OnPreSimulate_Internal);
+
+	if (const FMotionIntensityPhysicsInput* Input = GetConsumerInput_Internal())
+	{
+		for (const FMotionIntensityPhysicsInput::FAddedBody& AddedBody : Input->AddedBodies)
+		{
+			if (!Bodies.ContainsByPredicate([&AddedBody](const FBody& Body) { return Body.Id == AddedBody.Id; }))
+			{
+				FBody& Body = Bodies.AddDefaulted_GetRef();
+				Body.Id = AddedBody.Id;
+				Body.Proxy = AddedBody.Proxy;
+				Body.Config = AddedBody.Config;
+				Body.Coefficients = AddedBody.Coefficients;
+				Body.Output = AddedBody.Output;
+			}
+		}
+
+		for (const uint32 Id : Input->RemovedBodies)
+		{
+			Bodies.RemoveAllSwap([Id](const FBody& Body) { return Body.Id == Id; });
+		}
+
+		for (const uint32 Id : Input->ResetBodies)
+		{
+			if (FBody* Body = Bodies.FindByPredicate([Id](const FBody& Body) { return Body.Id == Id; }))
+			{
+				Body->ServiceData.Reset();
+			}
+		}
+	}
+
+	const float DeltaTime = GetDeltaTime_Internal();
+	if (DeltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	for (FBody& Body : Bodies)
+	{
+		// Removal arrives with the step that destroys the body, the proxy is only freed after it, but it's marked deleted
+		// and may have lost its handle already
+		const Chaos::FRigidBodyHandle_Internal* Handle = Body.Proxy->GetMarkedDeleted() ? nullptr : Body.Proxy->GetPhysicsThreadAPI();
+		if (!Handle)
+		{
+			continue;
+		}
+
+		const FVector Location = Handle->X();
+		const FQuat Rotation = Handle->R();
+
+		FMotionIntensityPhysicsSample Sample;
+		if (Handle->ObjectState() == Chaos::EObjectStateType::Dynamic && !Body.ServiceData.bSetPreviousTransformToCurrent)
+		{
+			const float LinearSpeed = static_cast<float>(Handle->V().Size());
+			const float AngularSpeed = static_cast<float>(Handle->W().Size() / UE_TWO_PI); // Radians to revolutions
+			Sample.MotionData = MotionIntensityCore::CalculateMotionDataFromVelocity<FMotionIntensityMotionData>(LinearSpeed, AngularSpeed, DeltaTime, Body.Config, Body.ServiceData);
+
+			// Keeps the transform path in sync in case the body stops being dynamic
+			Body.ServiceData.PreviousLocation = Location;
+			Body.ServiceData.PreviousRotation = Rotation;
+		}
+		else
+		{
+			Sample.MotionData = MotionIntensityCore::CalculateMotionData<FMotionIntensityMotionData>(Location, Rotation, DeltaTime, Body.Config, Body.ServiceData);
+		}
+		Sample.MotionIntensity = Body.Coefficients.GetMotionIntensity(Sample.MotionData);
+
+		Body.Output->Publish(Sample);
+	}
+}
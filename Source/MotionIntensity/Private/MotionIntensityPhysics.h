@@ -0,0 +1,126 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "Chaos/SimCallbackObject.h"
+#include "MotionIntensity.h"
+
+#include <atomic>
+
+class FSingleParticlePhysicsProxy;
+
+// Result of one physics step
+struct FMotionIntensityPhysicsSample
+{
+	FMotionIntensityMotionData MotionData;
+	float MotionIntensity = 0.0f;
+};
+
+// Latest sample of a body: overwritten by the physics thread every step, taken by the game thread.
+// The game thread only needs the newest step, so a stall never leaves it reading stale samples.
+// Lock-free triple buffer for a single producer and a single consumer: each side owns one buffer, and the third one is
+// handed over by swapping its index atomically, so neither thread ever waits for the other.
+class FMotionIntensityPhysicsOutput
+{
+public:
+	// Physics thread
+	void Publish(const FMotionIntensityPhysicsSample& Sample)
+	{
+		Buffers[WriteIndex] = Sample;
+		WriteIndex = SharedIndex.exchange(static_cast<uint8>(WriteIndex | FreshFlag), std::memory_order_acq_rel) & IndexMask;
+	}
+
+	// Game thread, returns false if no step ran since the last call
+	bool Take(FMotionIntensityPhysicsSample& OutSample)
+	{
+		if (!(SharedIndex.load(std::memory_order_relaxed) & FreshFlag))
+		{
+			return false;
+		}
+
+		ReadIndex = SharedIndex.exchange(ReadIndex, std::memory_order_acq_rel) & IndexMask;
+		OutSample = Buffers[ReadIndex];
+		return true;
+	}
+
+private:
+	// Set in the shared index while it holds a sample the game thread hasn't taken yet
+	static constexpr uint8 FreshFlag = 4;
+	static constexpr uint8 IndexMask = 3;
+
+	FMotionIntensityPhysicsSample Buffers[3];
+
+	// Physics thread only
+	uint8 WriteIndex = 0;
+
+	// Buffer between the threads
+	std::atomic<uint8> SharedIndex{1};
+
+	// Game thread only
+	uint8 ReadIndex = 2;
+};
+
+// Changes to the set of tracked bodies, marshalled to the physics thread by Chaos
+struct FMotionIntensityPhysicsInput : public Chaos::FSimCallbackInput
+{
+	struct FAddedBody
+	{
+		uint32 Id = 0;
+		FSingleParticlePhysicsProxy* Proxy = nullptr;
+		FMotionIntensityConfig Config;
+		FMotionIntensityCompiledCoefficients Coefficients;
+		TSharedPtr<FMotionIntensityPhysicsOutput, ESPMode::ThreadSafe> Output;
+	};
+
+	TArray<FAddedBody> AddedBodies;
+	TArray<uint32> RemovedBodies;
+	TArray<uint32> ResetBodies;
+
+	void Reset()
+	{
+		AddedBodies.Reset();
+		RemovedBodies.Reset();
+		ResetBodies.Reset();
+	}
+};
+
+// Evaluates motion intensity of physics bodies on the physics thread every physics step.
+// Dynamic bodies are evaluated from their own velocities, other bodies from their physics state transform,
+// so the result doesn't alias when physics runs at a higher rate than the game thread.
+// Commands may be seen by more than one step, so they are idempotent.
+// Bodies hold the proxy they were added with, so they have to be removed no later than the frame their physics state is
+// destroyed in, and added again once it's recreated, see UMotionIntensitySubsystem::OnPhysicsStateChanged.
+class FMotionIntensityPhysicsCallback : public Chaos::TSimCallbackObject<FMotionIntensityPhysicsInput>
+{
+public:
+	// Game thread, starts tracking a body and returns its id and the output its samples are published to
+	uint32 AddBody(FSingleParticlePhysicsProxy* Proxy,
+	               const FMotionIntensityConfig& Config,
+	               const FMotionIntensityCoefficients& Coefficients,
+	               TSharedPtr<FMotionIntensityPhysicsOutput, ESPMode::ThreadSafe>& OutOutput);
+
+	// Game thread, the proxy of the body must still be alive when this frame's commands reach the physics thread
+	void RemoveBody(uint32 Id);
+
+	// Game thread, next step starts from the body's current transform
+	void ResetBody(uint32 Id);
+
+private:
+	virtual void OnPreSimulate_Internal() override;
+
+	struct FBody
+	{
+		uint32 Id = 0;
+		FSingleParticlePhysicsProxy* Proxy = nullptr;
+		FMotionIntensityConfig Config;
+		FMotionIntensityCompiledCoefficients Coefficients;
+		FMotionIntensityServiceData ServiceData;
+		TSharedPtr<FMotionIntensityPhysicsOutput, ESPMode::ThreadSafe> Output;
+	};
+
+	// Physics thread only
+	TArray<FBody> Bodies;
+
+	// Game thread only
+	uint32 NextId = 1;
+};
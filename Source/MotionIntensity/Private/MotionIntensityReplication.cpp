@@ -0,0 +1,150 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityReplication.h"
+#include "MotionIntensityCoreAdapters.h"
+#include "Math/Float16.h"
+
+namespace
+{
+	using FChannel = float FMotionIntensityMotionData::*;
+
+	constexpr FChannel MotionDataChannels[] = {
+		&FMotionIntensityMotionData::LinearVelocityNormalized,
+		&FMotionIntensityMotionData::PositiveLinearAccelerationNormalized,
+		&FMotionIntensityMotionData::NegativeLinearAccelerationNormalized,
+		&FMotionIntensityMotionData::PositiveLinearJerkNormalized,
+		&FMotionIntensityMotionData::NegativeLinearJerkNormalized,
+		&FMotionIntensityMotionData::AngularVelocityNormalized,
+		&FMotionIntensityMotionData::PositiveAngularAccelerationNormalized,
+		&FMotionIntensityMotionData::NegativeAngularAccelerationNormalized,
+		&FMotionIntensityMotionData::PositiveAngularJerkNormalized,
+		&FMotionIntensityMotionData::NegativeAngularJerkNormalized
+	};
+
+	static_assert(UE_ARRAY_COUNT(MotionDataChannels) == FMotionIntensityReplicatedData::NumChannels);
+
+	constexpr float ChannelStep = FMotionIntensityReplicatedData::MaxChannelValue / FMotionIntensityReplicatedData::MaxQuantizedChannel;
+
+	uint16 QuantizeChannel(const float Value)
+	{
+		const float Clamped = FMath::Clamp(Value, 0.0f, FMotionIntensityReplicatedData::MaxChannelValue);
+		return static_cast<uint16>(FMath::RoundToInt32(Clamped / ChannelStep));
+	}
+
+	float DequantizeChannel(const uint16 Quantized)
+	{
+		return Quantized * ChannelStep;
+	}
+
+	uint16 QuantizeMotionIntensity(const float Value)
+	{
+		return FFloat16(FMath::Max(0.0f, Value)).Encoded;
+	}
+
+	float DequantizeMotionIntensity(const uint16 Encoded)
+	{
+		FFloat16 Half;
+		Half.Encoded = Encoded;
+		return Half.GetFloat();
+	}
+}
+
+/* Public methods */
+
+FMotionIntensityReplicatedData::FMotionIntensityReplicatedData(const FMotionIntensityMotionData& MotionData,
+                                                               const float InMotionIntensity)
+{
+	for (int32 Index = 0; Index < NumChannels; ++Index)
+	{
+		Channels[Index] = QuantizeChannel(MotionData.*MotionDataChannels[Index]);
+	}
+	MotionIntensity = QuantizeMotionIntensity(InMotionIntensity);
+}
+
+bool FMotionIntensityReplicatedData::Update(const FMotionIntensityMotionData& MotionData,
+                                            const float InMotionIntensity,
+                                            const float Threshold)
+{
+	const FMotionIntensityReplicatedData Updated(MotionData, InMotionIntensity);
+
+	bool bChanged = FMath::Abs(Updated.GetMotionIntensity() - GetMotionIntensity()) > Threshold;
+	for (int32 Index = 0; Index < NumChannels && !bChanged; ++Index)
+	{
+		bChanged = FMath::Abs(DequantizeChannel(Updated.Channels[Index]) - DequantizeChannel(Channels[Index])) > Threshold;
+	}
+
+	if (bChanged)
+	{
+		*this = Updated;
+	}
+	return bChanged;
+}
+
+FMotionIntensityMotionData FMotionIntensityReplicatedData::GetMotionData() const
+{
+	FMotionIntensityMotionData MotionData;
+	for (int32 Index = 0; Index < NumChannels; ++Index)
+	{
+		MotionData.*MotionDataChannels[Index] = DequantizeChannel(Channels[Index]);
+	}
+	return MotionData;
+}
+
+float FMotionIntensityReplicatedData::GetMotionIntensity() const
+{
+	return DequantizeMotionIntensity(MotionIntensity);
+}
+
+void FMotionIntensityReplicatedData::ApplyTo(FMotionIntensityServiceData& ServiceData, const FMotionIntensityConfig& Config) const
+{
+	const FMotionIntensityMotionData MotionData = GetMotionData();
+
+	// Smoothed values the next derivatives are taken from, the core keeps them normalized. Filters with more memory than
+	// their previous output are settled at them, otherwise their stale state would start a transient on every update.
+	MotionIntensityCore::SettleFilters(MotionData.LinearVelocityNormalized,
+	                                   MotionData.PositiveLinearAccelerationNormalized - MotionData.NegativeLinearAccelerationNormalized,
+	                                   MotionData.AngularVelocityNormalized,
+	                                   MotionData.PositiveAngularAccelerationNormalized - MotionData.NegativeAngularAccelerationNormalized,
+	                                   Config,
+	                                   ServiceData);
+	ServiceData.PreviousLinearJerk = MotionData.PositiveLinearJerkNormalized - MotionData.NegativeLinearJerkNormalized;
+	ServiceData.PreviousAngularJerk = MotionData.PositiveAngularJerkNormalized - MotionData.NegativeAngularJerkNormalized;
+	ServiceData.FixedStepMotionData = MotionData;
+}
+
+bool FMotionIntensityReplicatedData::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// One bit per channel, only non-zero channels follow
+	uint32 ChannelMask = 0;
+	if (Ar.IsSaving())
+	{
+		for (int32 Index = 0; Index < NumChannels; ++Index)
+		{
+			ChannelMask |= Channels[Index] != 0 ? 1u << Index : 0u;
+		}
+	}
+	Ar.SerializeBits(&ChannelMask, NumChannels);
+
+	for (int32 Index = 0; Index < NumChannels; ++Index)
+	{
+		uint32 Quantized = Channels[Index];
+		if (ChannelMask & (1u << Index))
+		{
+			Ar.SerializeInt(Quantized, MaxQuantizedChannel + 1);
+		}
+		else
+		{
+			Quantized = 0;
+		}
+
+		if (Ar.IsLoading())
+		{
+			Channels[Index] = static_cast<uint16>(Quantized);
+		}
+	}
+
+	Ar << MotionIntensity;
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
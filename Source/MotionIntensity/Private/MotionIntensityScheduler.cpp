@@ -0,0 +1,132 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityScheduler.h"
+#include "MotionIntensityValidation.h"
+
+FMotionIntensityScheduler::FMotionIntensityScheduler(TArray<float> InSignificanceThresholds)
+	: SignificanceThresholds(MoveTemp(InSignificanceThresholds))
+{
+	// Intervals are kept in a byte-sized shift and phases have to cover the longest interval
+	check(SignificanceThresholds.Num() < 16);
+}
+
+/* Public methods */
+
+int32 FMotionIntensityScheduler::Add(const float Significance)
+{
+	IntervalShifts.Add(GetIntervalShift(Significance));
+	Phases.Add(NextPhase++);
+	AccumulatedDeltaTimes.Add(0.0f);
+	AccumulatedFrames.Add(0);
+	return Batch.Add();
+}
+
+void FMotionIntensityScheduler::RemoveAtSwap(const int32 Index)
+{
+	Batch.RemoveAtSwap(Index);
+	IntervalShifts.RemoveAtSwap(Index);
+	Phases.RemoveAtSwap(Index);
+	AccumulatedDeltaTimes.RemoveAtSwap(Index);
+	AccumulatedFrames.RemoveAtSwap(Index);
+}
+
+void FMotionIntensityScheduler::ResetEntry(const int32 Index)
+{
+	Batch.ResetEntry(Index);
+	AccumulatedDeltaTimes[Index] = 0.0f;
+	AccumulatedFrames[Index] = 0;
+}
+
+void FMotionIntensityScheduler::Empty()
+{
+	Batch.Empty();
+	IntervalShifts.Empty();
+	Phases.Empty();
+	AccumulatedDeltaTimes.Empty();
+	AccumulatedFrames.Empty();
+	DueIndices.Empty();
+}
+
+void FMotionIntensityScheduler::SetSignificance(const int32 Index, const float Significance)
+{
+	IntervalShifts[Index] = GetIntervalShift(Significance);
+}
+
+int32 FMotionIntensityScheduler::GetUpdateInterval(const int32 Index) const
+{
+	return 1 << IntervalShifts[Index];
+}
+
+float FMotionIntensityScheduler::GetDistanceSignificance(const FVector& Location,
+                                                         const TArrayView<const FVector> ViewLocations,
+                                                         const float MaxDistance)
+{
+	if (ViewLocations.Num() == 0 || MaxDistance <= 0.0f)
+	{
+		return 1.0f;
+	}
+
+	double MinDistanceSquared = TNumericLimits<double>::Max();
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(Location, ViewLocation));
+	}
+	return 1.0f - FMath::Min(1.0f, static_cast<float>(FMath::Sqrt(MinDistanceSquared)) / MaxDistance);
+}
+
+bool FMotionIntensityScheduler::Update(const TArrayView<const FVector> Locations,
+                                       const TArrayView<const FQuat> Rotations,
+                                       const float DeltaTime,
+                                       const FMotionIntensityConfig& Config,
+                                       const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+                                       const TArrayView<FMotionIntensityMotionData> OutMotionData,
+                                       const TArrayView<float> OutMotionIntensities)
+{
+	DueIndices.Reset();
+
+	// Validated before anything advances, so a rejected update leaves the scheduler as it was
+	if (!MotionIntensityValidation::ValidateDeltaTime(DeltaTime)
+		|| !MotionIntensityValidation::ValidateConfig(Config)
+		|| !MotionIntensityValidation::ValidateCoefficients(CompiledCoefficients))
+	{
+		return false;
+	}
+
+	const int32 Number = Num();
+	for (int32 Index = 0; Index < Number; ++Index)
+	{
+		AccumulatedDeltaTimes[Index] += DeltaTime;
+		AccumulatedFrames[Index] += 1;
+
+		// Intervals are powers of two, so entries of every interval are spread evenly over its frames
+		const uint32 IntervalMask = (1u << IntervalShifts[Index]) - 1;
+		if ((FrameCounter & IntervalMask) == (Phases[Index] & IntervalMask))
+		{
+			DueIndices.Add(Index);
+		}
+	}
+	++FrameCounter;
+
+	// Inputs were validated above, and every accumulated time and frame count of a due entry is positive
+	verify(Batch.GetMotionIntensity(DueIndices, Locations, Rotations, AccumulatedDeltaTimes, AccumulatedFrames, Config, CompiledCoefficients,
+	                                OutMotionData, OutMotionIntensities));
+
+	for (const int32 Index : DueIndices)
+	{
+		AccumulatedDeltaTimes[Index] = 0.0f;
+		AccumulatedFrames[Index] = 0;
+	}
+	return true;
+}
+
+/* Private methods */
+
+uint8 FMotionIntensityScheduler::GetIntervalShift(const float Significance) const
+{
+	uint8 Shift = 0;
+	while (Shift < SignificanceThresholds.Num() && Significance < SignificanceThresholds[Shift])
+	{
+		++Shift;
+	}
+	return Shift;
+}
@@ -0,0 +1,233 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensitySkeletalComponent.h"
+#include "MotionIntensityStats.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkinnedAsset.h"
+#include "GameFramework/Actor.h"
+
+UMotionIntensitySkeletalComponent::UMotionIntensitySkeletalComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+/* Public methods */
+
+void UMotionIntensitySkeletalComponent::SetPreset(UMotionIntensityPreset* NewPreset)
+{
+	Preset = NewPreset;
+}
+
+void UMotionIntensitySkeletalComponent::SetSkeletalMeshComponent(USkeletalMeshComponent* NewSkeletalMeshComponent)
+{
+	SkeletalMeshComponent = NewSkeletalMeshComponent;
+
+	if (HasBegunPlay())
+	{
+		UpdateTickPrerequisite();
+	}
+	ResolveBones();
+}
+
+USkeletalMeshComponent* UMotionIntensitySkeletalComponent::GetSkeletalMeshComponent() const
+{
+	if (SkeletalMeshComponent)
+	{
+		return SkeletalMeshComponent;
+	}
+
+	const AActor* Owner = GetOwner();
+	return Owner ? Owner->FindComponentByClass<USkeletalMeshComponent>() : nullptr;
+}
+
+void UMotionIntensitySkeletalComponent::SetBones(const TArray<FName>& NewBoneNames, const TArray<float>& NewBoneWeights)
+{
+	BoneNames = NewBoneNames;
+	BoneWeights = NewBoneWeights;
+	ResolveBones();
+}
+
+void UMotionIntensitySkeletalComponent::ResetMotionIntensity()
+{
+	for (int32 Index = 0; Index < Batch.Num(); ++Index)
+	{
+		Batch.ResetEntry(Index);
+	}
+
+	BoneMotionData.Init(FMotionIntensityMotionData(), BoneNames.Num());
+	BoneMotionIntensities.Init(0.0f, BoneNames.Num());
+	MaxMotionIntensity = 0.0f;
+	RMSMotionIntensity = 0.0f;
+	WeightedMotionIntensity = 0.0f;
+}
+
+float UMotionIntensitySkeletalComponent::GetBoneMotionIntensity(const FName BoneName) const
+{
+	const int32 Index = BoneNames.IndexOfByKey(BoneName);
+	return BoneMotionIntensities.IsValidIndex(Index) ? BoneMotionIntensities[Index] : 0.0f;
+}
+
+void UMotionIntensitySkeletalComponent::TickComponent(const float DeltaTime,
+                                                      const ELevelTick TickType,
+                                                      FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_SkeletalTick);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	USkeletalMeshComponent* Mesh = GetSkeletalMeshComponent();
+	if (!Mesh || BoneNames.Num() == 0)
+	{
+		return;
+	}
+
+	if (PrerequisiteComponent.Get() != Mesh)
+	{
+		UpdateTickPrerequisite();
+	}
+	if (BoneIndices.Num() != BoneNames.Num() || ResolvedAsset.Get() != Mesh->GetSkinnedAsset())
+	{
+		ResolveBones();
+	}
+
+	// Followers of a leader pose have no buffer of their own, their bones are read from the leader's through the bone map
+	const USkinnedMeshComponent* PoseComponent = Mesh;
+	const TArray<int32>* LeaderBoneMap = nullptr;
+	if (const USkinnedMeshComponent* LeaderPoseComponent = Mesh->LeaderPoseComponent.Get())
+	{
+		PoseComponent = LeaderPoseComponent;
+		LeaderBoneMap = &Mesh->GetLeaderBoneMap();
+	}
+	const TArray<FTransform>& ComponentSpaceTransforms = PoseComponent->GetComponentSpaceTransforms();
+	const FTransform& ComponentTransform = PoseComponent->GetComponentTransform();
+
+	const int32 Number = BoneIndices.Num();
+	Locations.SetNumUninitialized(Number);
+	Rotations.SetNumUninitialized(Number);
+
+	for (int32 Index = 0; Index < Number; ++Index)
+	{
+		int32 BoneIndex = BoneIndices[Index];
+		if (LeaderBoneMap)
+		{
+			BoneIndex = LeaderBoneMap->IsValidIndex(BoneIndex) ? (*LeaderBoneMap)[BoneIndex] : INDEX_NONE;
+		}
+
+		if (ComponentSpaceTransforms.IsValidIndex(BoneIndex))
+		{
+			const FTransform Transform = bWorldSpace
+				                             ? ComponentSpaceTransforms[BoneIndex] * ComponentTransform
+				                             : ComponentSpaceTransforms[BoneIndex];
+			Locations[Index] = Transform.GetLocation();
+			Rotations[Index] = Transform.GetRotation();
+		}
+		else
+		{
+			// Hold the previous transform so the motion decays instead of jumping
+			const FMotionIntensityServiceData ServiceData = Batch.GetServiceData(Index);
+			Locations[Index] = ServiceData.PreviousLocation;
+			Rotations[Index] = ServiceData.PreviousRotation;
+		}
+	}
+
+	static const FMotionIntensityConfig DefaultConfig;
+	static const FMotionIntensityCoefficients DefaultCoefficients;
+	const FMotionIntensityConfig& Config = Preset ? Preset->MotionIntensityConfig : DefaultConfig;
+	const FMotionIntensityCoefficients& Coefficients = Preset ? Preset->Coefficients : DefaultCoefficients;
+
+	if (Batch.GetMotionIntensity(Locations, Rotations, DeltaTime, Config, Coefficients, BoneMotionData, BoneMotionIntensities))
+	{
+		UpdateAggregates();
+	}
+}
+
+void UMotionIntensitySkeletalComponent::ApplyWorldOffset(const FVector& InOffset, const bool bWorldShift)
+{
+	Super::ApplyWorldOffset(InOffset, bWorldShift);
+
+	// Bones tracked relative to the mesh don't move with the world
+	if (bWorldSpace)
+	{
+		Batch.ApplyWorldOffset(InOffset);
+	}
+}
+
+/* Protected methods */
+
+void UMotionIntensitySkeletalComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UpdateTickPrerequisite();
+	ResolveBones();
+}
+
+void UMotionIntensitySkeletalComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (USkeletalMeshComponent* Mesh = PrerequisiteComponent.Get())
+	{
+		RemoveTickPrerequisiteComponent(Mesh);
+	}
+	PrerequisiteComponent.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+/* Private methods */
+
+void UMotionIntensitySkeletalComponent::ResolveBones()
+{
+	const USkeletalMeshComponent* Mesh = GetSkeletalMeshComponent();
+	ResolvedAsset = Mesh ? Mesh->GetSkinnedAsset() : nullptr;
+
+	Batch.Empty();
+	Batch.Reserve(BoneNames.Num());
+	BoneIndices.Reset(BoneNames.Num());
+
+	for (const FName BoneName : BoneNames)
+	{
+		BoneIndices.Add(Mesh ? Mesh->GetBoneIndex(BoneName) : INDEX_NONE);
+		Batch.Add();
+	}
+
+	ResetMotionIntensity();
+}
+
+void UMotionIntensitySkeletalComponent::UpdateTickPrerequisite()
+{
+	if (USkeletalMeshComponent* OldMesh = PrerequisiteComponent.Get())
+	{
+		RemoveTickPrerequisiteComponent(OldMesh);
+	}
+
+	USkeletalMeshComponent* Mesh = GetSkeletalMeshComponent();
+	if (Mesh)
+	{
+		AddTickPrerequisiteComponent(Mesh);
+	}
+	PrerequisiteComponent = Mesh;
+}
+
+void UMotionIntensitySkeletalComponent::UpdateAggregates()
+{
+	const int32 Number = BoneMotionIntensities.Num();
+
+	float Max = 0.0f;
+	float SumOfSquares = 0.0f;
+	float WeightedSum = 0.0f;
+	float SumOfWeights = 0.0f;
+	for (int32 Index = 0; Index < Number; ++Index)
+	{
+		const float MotionIntensity = BoneMotionIntensities[Index];
+		const float Weight = BoneWeights.IsValidIndex(Index) ? BoneWeights[Index] : 1.0f;
+		Max = FMath::Max(Max, MotionIntensity);
+		SumOfSquares += MotionIntensity * MotionIntensity;
+		WeightedSum += MotionIntensity * Weight;
+		SumOfWeights += Weight;
+	}
+
+	MaxMotionIntensity = Max;
+	RMSMotionIntensity = Number > 0 ? FMath::Sqrt(SumOfSquares / Number) : 0.0f;
+	WeightedMotionIntensity = SumOfWeights > UE_SMALL_NUMBER ? WeightedSum / SumOfWeights : 0.0f;
+}
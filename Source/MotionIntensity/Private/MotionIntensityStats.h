@@ -0,0 +1,23 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("MotionIntensity"), STATGROUP_MotionIntensity, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Calculate Motion Data"), STAT_MotionIntensity_CalculateMotionData, STATGROUP_MotionIntensity, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Motion Intensity From Motion Data"), STAT_MotionIntensity_GetMotionIntensity, STATGROUP_MotionIntensity, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batch Evaluate"), STAT_MotionIntensity_BatchEvaluate, STATGROUP_MotionIntensity, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Subsystem Tick"), STAT_MotionIntensity_SubsystemTick, STATGROUP_MotionIntensity, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Evaluate Track"), STAT_MotionIntensity_EvaluateTrack, STATGROUP_MotionIntensity, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Skeletal Tick"), STAT_MotionIntensity_SkeletalTick, STATGROUP_MotionIntensity, );
+
+// Objects run through the kernels this frame, batches count every entry
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Objects Evaluated"), STAT_MotionIntensity_ObjectsEvaluated, STATGROUP_MotionIntensity, );
+
+// Batches whose origin moved this frame to follow their objects
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Origin Rebases"), STAT_MotionIntensity_OriginRebases, STATGROUP_MotionIntensity, );
+
+// Calls rejected this frame because of invalid Delta Time, config or coefficients
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rejected Calls"), STAT_MotionIntensity_RejectedCalls, STATGROUP_MotionIntensity, );
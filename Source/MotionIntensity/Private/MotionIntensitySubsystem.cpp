@@ -0,0 +1,458 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensitySubsystem.h"
+#include "MotionIntensityComponent.h"
+#include "MotionIntensityPhysics.h"
+#include "MotionIntensityStats.h"
+#include "MotionIntensityValidation.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PBDRigidsSolver.h"
+
+/* Tick function */
+
+void FMotionIntensitySubsystemTickFunction::ExecuteTick(const float DeltaTime,
+                                                        ELevelTick TickType,
+                                                        ENamedThreads::Type CurrentThread,
+                                                        const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Subsystem)
+	{
+		Subsystem->Tick(DeltaTime);
+	}
+}
+
+FString FMotionIntensitySubsystemTickFunction::DiagnosticMessage()
+{
+	return TEXT("MotionIntensitySubsystem");
+}
+
+/* Public methods */
+
+void UMotionIntensitySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Subsystem = this;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.TickGroup = TG_PostPhysics;
+	TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+
+	WorldOriginOffsetHandle = FWorldDelegates::OnPostWorldOriginOffset.AddUObject(this, &UMotionIntensitySubsystem::OnWorldOriginOffset);
+}
+
+void UMotionIntensitySubsystem::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	TickFunction.Subsystem = nullptr;
+
+	FWorldDelegates::OnPostWorldOriginOffset.Remove(WorldOriginOffsetHandle);
+	WorldOriginOffsetHandle.Reset();
+
+	for (FComponentGroup& Group : Groups)
+	{
+		for (UMotionIntensityComponent* Component : Group.Components)
+		{
+			Component->GroupIndex = INDEX_NONE;
+			Component->EntryIndex = INDEX_NONE;
+		}
+	}
+	Groups.Empty();
+
+	for (const FPhysicsEntry& Entry : PhysicsEntries)
+	{
+		Entry.Component->PhysicsEntryIndex = INDEX_NONE;
+		if (UPrimitiveComponent* PrimitiveComponent = Entry.PrimitiveComponent.Get())
+		{
+			PrimitiveComponent->OnComponentPhysicsStateChanged.RemoveDynamic(this, &UMotionIntensitySubsystem::OnPhysicsStateChanged);
+		}
+	}
+	PhysicsEntries.Empty();
+
+	if (PhysicsCallback)
+	{
+		if (FPhysScene* PhysicsScene = GetWorld()->GetPhysicsScene())
+		{
+			PhysicsScene->GetSolver()->UnregisterAndFreeSimCallbackObject_External(PhysicsCallback);
+		}
+		PhysicsCallback = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+void UMotionIntensitySubsystem::RegisterComponent(UMotionIntensityComponent* Component)
+{
+	check(Component);
+
+	if (Component->IsRegisteredWithSubsystem())
+	{
+		return;
+	}
+
+	if (Component->bEvaluateOnPhysicsThread && RegisterPhysicsComponent(Component))
+	{
+		return;
+	}
+
+	const UMotionIntensityPreset* Preset = Component->GetPreset();
+	const bool bUseComponentVelocity = Component->bUseComponentVelocity;
+	int32 GroupIndex = Groups.IndexOfByPredicate([Preset, bUseComponentVelocity](const FComponentGroup& Group)
+	{
+		return Group.Preset == Preset && Group.bUseComponentVelocity == bUseComponentVelocity;
+	});
+	if (GroupIndex == INDEX_NONE)
+	{
+		GroupIndex = Groups.AddDefaulted();
+		Groups[GroupIndex].Preset = Preset;
+		Groups[GroupIndex].bUseComponentVelocity = bUseComponentVelocity;
+	}
+
+	FComponentGroup& Group = Groups[GroupIndex];
+	Component->GroupIndex = GroupIndex;
+	Component->EntryIndex = Group.Batch.Add();
+	Group.Components.Add(Component);
+	check(Group.Components.Num() == Group.Batch.Num());
+}
+
+void UMotionIntensitySubsystem::UnregisterComponent(UMotionIntensityComponent* Component)
+{
+	check(Component);
+
+	if (Component->PhysicsEntryIndex != INDEX_NONE)
+	{
+		UnregisterPhysicsComponent(Component);
+		return;
+	}
+
+	if (!Groups.IsValidIndex(Component->GroupIndex))
+	{
+		return;
+	}
+
+	FComponentGroup& Group = Groups[Component->GroupIndex];
+	const int32 EntryIndex = Component->EntryIndex;
+	check(Group.Components.IsValidIndex(EntryIndex) && Group.Components[EntryIndex] == Component);
+
+	// Batch and component list are swapped the same way, so indices stay in sync
+	Group.Batch.RemoveAtSwap(EntryIndex);
+	Group.Components.RemoveAtSwap(EntryIndex);
+	if (Group.Components.IsValidIndex(EntryIndex))
+	{
+		Group.Components[EntryIndex]->EntryIndex = EntryIndex;
+	}
+
+	Component->GroupIndex = INDEX_NONE;
+	Component->EntryIndex = INDEX_NONE;
+
+	// Empty groups are kept, so group indices of other components stay valid
+}
+
+void UMotionIntensitySubsystem::ResetComponent(const UMotionIntensityComponent* Component)
+{
+	check(Component);
+
+	if (Groups.IsValidIndex(Component->GroupIndex))
+	{
+		Groups[Component->GroupIndex].Batch.ResetEntry(Component->EntryIndex);
+	}
+	else if (PhysicsEntries.IsValidIndex(Component->PhysicsEntryIndex) && PhysicsEntries[Component->PhysicsEntryIndex].BodyId != 0)
+	{
+		PhysicsCallback->ResetBody(PhysicsEntries[Component->PhysicsEntryIndex].BodyId);
+	}
+}
+
+void UMotionIntensitySubsystem::ApplyReplicatedData(const UMotionIntensityComponent* Component,
+                                                    const FMotionIntensityReplicatedData& ReplicatedData)
+{
+	check(Component);
+
+	if (Groups.IsValidIndex(Component->GroupIndex))
+	{
+		static const FMotionIntensityConfig DefaultConfig;
+		FComponentGroup& Group = Groups[Component->GroupIndex];
+		const FMotionIntensityConfig& Config = Group.Preset ? Group.Preset->MotionIntensityConfig : DefaultConfig;
+
+		FMotionIntensityBatch& Batch = Group.Batch;
+		FMotionIntensityServiceData ServiceData = Batch.GetServiceData(Component->EntryIndex);
+		ReplicatedData.ApplyTo(ServiceData, Config);
+		Batch.SetServiceData(Component->EntryIndex, ServiceData);
+	}
+}
+
+void UMotionIntensitySubsystem::Tick(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_SubsystemTick);
+
+	TickPhysicsEntries(DeltaTime);
+
+	if (DeltaTime > 0.0f)
+	{
+		for (FComponentGroup& Group : Groups)
+		{
+			if (Group.Components.Num() > 0)
+			{
+				TickGroup(Group, DeltaTime);
+			}
+		}
+	}
+
+	BroadcastThresholdEvents();
+}
+
+/* Protected methods */
+
+bool UMotionIntensitySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+/* Private methods */
+
+void UMotionIntensitySubsystem::TickGroup(FComponentGroup& Group, const float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UMotionIntensitySubsystem::TickGroup);
+
+	const int32 Number = Group.Components.Num();
+	Group.MotionData.SetNumUninitialized(Number);
+	Group.MotionIntensities.SetNumUninitialized(Number);
+
+	static const FMotionIntensityConfig DefaultConfig;
+	static const FMotionIntensityCoefficients DefaultCoefficients;
+	const FMotionIntensityConfig& Config = Group.Preset ? Group.Preset->MotionIntensityConfig : DefaultConfig;
+	const FMotionIntensityCoefficients& Coefficients = Group.Preset ? Group.Preset->Coefficients : DefaultCoefficients;
+
+	bool bEvaluated;
+	if (Group.bUseComponentVelocity)
+	{
+		Group.LinearVelocities.SetNumUninitialized(Number);
+		Group.AngularVelocities.SetNumUninitialized(Number);
+
+		for (int32 Index = 0; Index < Number; ++Index)
+		{
+			// Nothing to track means zero velocity, so the motion decays
+			const USceneComponent* SceneComponent = Group.Components[Index]->GetTrackedComponent();
+			const UPrimitiveComponent* PrimitiveComponent = Cast<UPrimitiveComponent>(SceneComponent);
+			Group.LinearVelocities[Index] = SceneComponent ? SceneComponent->GetComponentVelocity() : FVector::ZeroVector;
+			Group.AngularVelocities[Index] = PrimitiveComponent && PrimitiveComponent->IsSimulatingPhysics()
+				                                 ? PrimitiveComponent->GetPhysicsAngularVelocityInRadians()
+				                                 : FVector::ZeroVector;
+		}
+
+		bEvaluated = Group.Batch.GetMotionIntensityFromVelocity(Group.LinearVelocities, Group.AngularVelocities, DeltaTime, Config, Coefficients,
+		                                                        Group.MotionData, Group.MotionIntensities);
+	}
+	else
+	{
+		Group.Locations.SetNumUninitialized(Number);
+		Group.Rotations.SetNumUninitialized(Number);
+
+		for (int32 Index = 0; Index < Number; ++Index)
+		{
+			if (const USceneComponent* SceneComponent = Group.Components[Index]->GetTrackedComponent())
+			{
+				const FTransform& Transform = SceneComponent->GetComponentTransform();
+				Group.Locations[Index] = Transform.GetLocation();
+				Group.Rotations[Index] = Transform.GetRotation();
+			}
+			else
+			{
+				// Nothing to track, hold the previous transform so the motion decays instead of jumping
+				const FMotionIntensityServiceData ServiceData = Group.Batch.GetServiceData(Index);
+				Group.Locations[Index] = ServiceData.PreviousLocation;
+				Group.Rotations[Index] = ServiceData.PreviousRotation;
+			}
+		}
+
+		bEvaluated = Group.Batch.GetMotionIntensity(Group.Locations, Group.Rotations, DeltaTime, Config, Coefficients,
+		                                            Group.MotionData, Group.MotionIntensities);
+	}
+
+	if (!bEvaluated)
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < Number; ++Index)
+	{
+		UpdateComponent(Group.Components[Index], Group.MotionData[Index], Group.MotionIntensities[Index], DeltaTime);
+	}
+}
+
+void UMotionIntensitySubsystem::OnWorldOriginOffset(UWorld* World, const FIntVector SourceOrigin, const FIntVector DestinationOrigin)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	// Same offset the world applies to its actors. Physics thread entries are left alone, Chaos doesn't shift its bodies.
+	const FVector Offset(SourceOrigin - DestinationOrigin);
+	for (FComponentGroup& Group : Groups)
+	{
+		Group.Batch.ApplyWorldOffset(Offset);
+	}
+}
+
+void UMotionIntensitySubsystem::TickPhysicsEntries(const float DeltaTime)
+{
+	for (const FPhysicsEntry& Entry : PhysicsEntries)
+	{
+		// Only the latest physics step is kept, components without a body hold their last update
+		FMotionIntensityPhysicsSample Sample;
+		if (Entry.Output && Entry.Output->Take(Sample))
+		{
+			UpdateComponent(Entry.Component, Sample.MotionData, Sample.MotionIntensity, DeltaTime);
+		}
+	}
+}
+
+void UMotionIntensitySubsystem::BroadcastThresholdEvents()
+{
+	// Handlers may unregister or destroy components, so the list is taken over first
+	const TArray<TWeakObjectPtr<UMotionIntensityComponent>> Components = MoveTemp(ThresholdEventComponents);
+	ThresholdEventComponents.Reset();
+
+	for (const TWeakObjectPtr<UMotionIntensityComponent>& Component : Components)
+	{
+		if (UMotionIntensityComponent* ValidComponent = Component.Get())
+		{
+			ValidComponent->BroadcastThresholdEvents();
+		}
+	}
+}
+
+bool UMotionIntensitySubsystem::RegisterPhysicsComponent(UMotionIntensityComponent* Component)
+{
+	UPrimitiveComponent* PrimitiveComponent = Cast<UPrimitiveComponent>(Component->GetTrackedComponent());
+	const FBodyInstance* BodyInstance = PrimitiveComponent ? PrimitiveComponent->GetBodyInstance() : nullptr;
+	FPhysicsActorHandle ActorHandle = BodyInstance ? BodyInstance->GetPhysicsActorHandle() : nullptr;
+	FPhysScene* PhysicsScene = GetWorld()->GetPhysicsScene();
+	if (!ActorHandle || !PhysicsScene)
+	{
+		return false;
+	}
+
+	static const FMotionIntensityConfig DefaultConfig;
+	static const FMotionIntensityCoefficients DefaultCoefficients;
+	const UMotionIntensityPreset* Preset = Component->GetPreset();
+	const FMotionIntensityConfig& Config = Preset ? Preset->MotionIntensityConfig : DefaultConfig;
+	const FMotionIntensityCoefficients& Coefficients = Preset ? Preset->Coefficients : DefaultCoefficients;
+	if (!MotionIntensityValidation::ValidateConfig(Config) || !MotionIntensityValidation::ValidateCoefficients(Coefficients))
+	{
+		return false;
+	}
+
+	if (!PhysicsCallback)
+	{
+		PhysicsCallback = PhysicsScene->GetSolver()->CreateAndRegisterSimCallbackObject_External<FMotionIntensityPhysicsCallback>();
+	}
+
+	FPhysicsEntry& Entry = PhysicsEntries.AddDefaulted_GetRef();
+	Entry.Component = Component;
+	Entry.PrimitiveComponent = PrimitiveComponent;
+	AddPhysicsBody(Entry, ActorHandle);
+	Component->PhysicsEntryIndex = PhysicsEntries.Num() - 1;
+
+	PrimitiveComponent->OnComponentPhysicsStateChanged.AddUniqueDynamic(this, &UMotionIntensitySubsystem::OnPhysicsStateChanged);
+	return true;
+}
+
+void UMotionIntensitySubsystem::UnregisterPhysicsComponent(UMotionIntensityComponent* Component)
+{
+	const int32 EntryIndex = Component->PhysicsEntryIndex;
+	check(PhysicsEntries.IsValidIndex(EntryIndex) && PhysicsEntries[EntryIndex].Component == Component);
+
+	const FPhysicsEntry& Entry = PhysicsEntries[EntryIndex];
+	if (Entry.BodyId != 0)
+	{
+		PhysicsCallback->RemoveBody(Entry.BodyId);
+	}
+
+	// Other components may track the same primitive
+	UPrimitiveComponent* PrimitiveComponent = Entry.PrimitiveComponent.Get();
+	if (PrimitiveComponent && !PhysicsEntries.ContainsByPredicate([&Entry](const FPhysicsEntry& Other)
+	{
+		return &Other != &Entry && Other.PrimitiveComponent == Entry.PrimitiveComponent;
+	}))
+	{
+		PrimitiveComponent->OnComponentPhysicsStateChanged.RemoveDynamic(this, &UMotionIntensitySubsystem::OnPhysicsStateChanged);
+	}
+
+	PhysicsEntries.RemoveAtSwap(EntryIndex);
+	if (PhysicsEntries.IsValidIndex(EntryIndex))
+	{
+		PhysicsEntries[EntryIndex].Component->PhysicsEntryIndex = EntryIndex;
+	}
+
+	Component->PhysicsEntryIndex = INDEX_NONE;
+}
+
+void UMotionIntensitySubsystem::AddPhysicsBody(FPhysicsEntry& Entry, FSingleParticlePhysicsProxy* Proxy)
+{
+	// Validated when the component was registered
+	static const FMotionIntensityConfig DefaultConfig;
+	static const FMotionIntensityCoefficients DefaultCoefficients;
+	const UMotionIntensityPreset* Preset = Entry.Component->GetPreset();
+	const FMotionIntensityConfig& Config = Preset ? Preset->MotionIntensityConfig : DefaultConfig;
+	const FMotionIntensityCoefficients& Coefficients = Preset ? Preset->Coefficients : DefaultCoefficients;
+
+	Entry.BodyId = PhysicsCallback->AddBody(Proxy, Config, Coefficients, Entry.Output);
+}
+
+void UMotionIntensitySubsystem::OnPhysicsStateChanged(UPrimitiveComponent* ChangedComponent, const EComponentPhysicsStateChange StateChange)
+{
+	for (FPhysicsEntry& Entry : PhysicsEntries)
+	{
+		if (Entry.PrimitiveComponent != ChangedComponent)
+		{
+			continue;
+		}
+
+		if (StateChange == EComponentPhysicsStateChange::Destroyed)
+		{
+			// Sent in the same frame the body is destroyed, so the physics thread drops it before the proxy is freed
+			if (Entry.BodyId != 0)
+			{
+				PhysicsCallback->RemoveBody(Entry.BodyId);
+				Entry.BodyId = 0;
+				Entry.Output.Reset();
+			}
+		}
+		else if (Entry.BodyId == 0)
+		{
+			const FBodyInstance* BodyInstance = ChangedComponent->GetBodyInstance();
+			if (FPhysicsActorHandle ActorHandle = BodyInstance ? BodyInstance->GetPhysicsActorHandle() : nullptr)
+			{
+				AddPhysicsBody(Entry, ActorHandle);
+			}
+		}
+	}
+}
+
+void UMotionIntensitySubsystem::UpdateComponent(UMotionIntensityComponent* Component,
+                                                const FMotionIntensityMotionData& MotionData,
+                                                const float MotionIntensity,
+                                                const float DeltaTime)
+{
+	Component->MotionData = MotionData;
+	Component->MotionIntensity = MotionIntensity;
+	if (Component->bTraceMotionIntensity)
+	{
+		Component->TraceMotionIntensity();
+	}
+	if (Component->bReplicateMotionIntensity)
+	{
+		Component->UpdateReplicatedMotionIntensity();
+	}
+	if (Component->Thresholds.Num() > 0 && Component->UpdateThresholds(DeltaTime))
+	{
+		ThresholdEventComponents.Add(Component);
+	}
+}
@@ -0,0 +1,66 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityThreshold.h"
+
+/* Public methods */
+
+bool FMotionIntensityThreshold::Update(const FMotionIntensityMotionData& MotionData, const float MotionIntensity, const float DeltaTime)
+{
+	const float Value = GetChannelValue(Channel, MotionData, MotionIntensity);
+	const bool bPastThreshold = bActive ? Value < FMath::Min(ExitThreshold, EnterThreshold) : Value >= EnterThreshold;
+	if (!bPastThreshold)
+	{
+		PendingTime = 0.0f;
+		return false;
+	}
+
+	PendingTime += DeltaTime;
+	if (PendingTime < (bActive ? ExitHoldTime : EnterHoldTime))
+	{
+		return false;
+	}
+
+	bActive = !bActive;
+	PendingTime = 0.0f;
+	return true;
+}
+
+void FMotionIntensityThreshold::Reset()
+{
+	bActive = false;
+	PendingTime = 0.0f;
+}
+
+float FMotionIntensityThreshold::GetChannelValue(const EMotionIntensityChannel InChannel,
+                                                 const FMotionIntensityMotionData& MotionData,
+                                                 const float MotionIntensity)
+{
+	switch (InChannel)
+	{
+	case EMotionIntensityChannel::MotionIntensity:
+		return MotionIntensity;
+	case EMotionIntensityChannel::LinearVelocity:
+		return MotionData.LinearVelocityNormalized;
+	case EMotionIntensityChannel::PositiveLinearAcceleration:
+		return MotionData.PositiveLinearAccelerationNormalized;
+	case EMotionIntensityChannel::NegativeLinearAcceleration:
+		return MotionData.NegativeLinearAccelerationNormalized;
+	case EMotionIntensityChannel::PositiveLinearJerk:
+		return MotionData.PositiveLinearJerkNormalized;
+	case EMotionIntensityChannel::NegativeLinearJerk:
+		return MotionData.NegativeLinearJerkNormalized;
+	case EMotionIntensityChannel::AngularVelocity:
+		return MotionData.AngularVelocityNormalized;
+	case EMotionIntensityChannel::PositiveAngularAcceleration:
+		return MotionData.PositiveAngularAccelerationNormalized;
+	case EMotionIntensityChannel::NegativeAngularAcceleration:
+		return MotionData.NegativeAngularAccelerationNormalized;
+	case EMotionIntensityChannel::PositiveAngularJerk:
+		return MotionData.PositiveAngularJerkNormalized;
+	case EMotionIntensityChannel::NegativeAngularJerk:
+		return MotionData.NegativeAngularJerkNormalized;
+	default:
+		checkNoEntry();
+		return 0.0f;
+	}
+}
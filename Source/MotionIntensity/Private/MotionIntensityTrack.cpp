@@ -0,0 +1,171 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityTrack.h"
+#include "MotionIntensityCoreAdapters.h"
+#include "MotionIntensityStats.h"
+#include "MotionIntensityValidation.h"
+
+/* Track evaluator */
+
+FMotionIntensityTrackEvaluator::FMotionIntensityTrackEvaluator(const FMotionIntensityConfig& InConfig,
+                                                               const FMotionIntensityCoefficients& InCoefficients)
+	: Config(InConfig)
+	, Coefficients(InCoefficients)
+{
+	bIsValid = MotionIntensityValidation::ValidateConfig(Config) && MotionIntensityValidation::ValidateCoefficients(InCoefficients);
+}
+
+void FMotionIntensityTrackEvaluator::Reset()
+{
+	ServiceData.Reset();
+	LastMotionData = FMotionIntensityMotionData();
+	LastMotionIntensity = 0.0f;
+	LastTime = 0.0;
+	bHasSample = false;
+}
+
+void FMotionIntensityTrackEvaluator::AddSample(const FTransform& Transform,
+                                               const double Time,
+                                               FMotionIntensityMotionData& OutMotionData,
+                                               float& OutMotionIntensity)
+{
+	const float DeltaTime = static_cast<float>(Time - LastTime);
+
+	if (bIsValid && bHasSample && DeltaTime > 0.0f)
+	{
+		LastMotionData = MotionIntensityCore::CalculateMotionData<FMotionIntensityMotionData>(Transform.GetLocation(),
+		                                                                                      Transform.GetRotation(),
+		                                                                                      DeltaTime,
+		                                                                                      Config,
+		                                                                                      ServiceData);
+		LastMotionIntensity = Coefficients.GetMotionIntensity(LastMotionData);
+		LastTime = Time;
+	}
+	else if (!bHasSample)
+	{
+		// Nothing to differentiate against yet, just remember where the track starts
+		ServiceData.Reset();
+		ServiceData.PreviousLocation = Transform.GetLocation();
+		ServiceData.PreviousRotation = Transform.GetRotation();
+		ServiceData.bSetPreviousTransformToCurrent = false;
+		LastTime = Time;
+		bHasSample = true;
+	}
+
+	OutMotionData = LastMotionData;
+	OutMotionIntensity = LastMotionIntensity;
+}
+
+bool FMotionIntensityTrackEvaluator::EvaluateTrack(const TArrayView<const FTransform> Transforms,
+                                                   const TArrayView<const float> Times,
+                                                   const float SampleRate,
+                                                   const TArrayView<float> OutMotionIntensities,
+                                                   const TArrayView<FMotionIntensityMotionData> OutMotionData)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MotionIntensity_EvaluateTrack);
+	check(OutMotionIntensities.Num() == Transforms.Num());
+	check(OutMotionData.Num() == 0 || OutMotionData.Num() == Transforms.Num());
+
+	if (!bIsValid)
+	{
+		return false;
+	}
+
+	if (Times.Num() != Transforms.Num() && SampleRate <= 0.0f)
+	{
+		MotionIntensityValidation::ReportError(EMotionIntensityError::InvalidInput, TEXT("Track needs either a time for every sample or a positive sample rate"));
+		return false;
+	}
+
+	Reset();
+	INC_DWORD_STAT_BY(STAT_MotionIntensity_ObjectsEvaluated, Transforms.Num());
+
+	const bool bUniform = Times.Num() != Transforms.Num();
+	FMotionIntensityMotionData MotionData;
+	for (int32 Index = 0; Index < Transforms.Num(); ++Index)
+	{
+		const double Time = bUniform ? Index / static_cast<double>(SampleRate) : Times[Index];
+		AddSample(Transforms[Index], Time, MotionData, OutMotionIntensities[Index]);
+		if (OutMotionData.Num() > 0)
+		{
+			OutMotionData[Index] = MotionData;
+		}
+	}
+
+	return true;
+}
+
+/* Blueprint library */
+
+// Baked tracks need a time for every sample, and every time later than the one before. The curve appends its keys
+// without searching, and the evaluator would repeat the previous result for a sample that doesn't move time forward.
+static bool ValidateTrackTimes(const TArray<FTransform>& Transforms, const TArray<float>& Times)
+{
+	if (Times.Num() != Transforms.Num())
+	{
+		MotionIntensityValidation::ReportError(EMotionIntensityError::InvalidInput, TEXT("Track needs a time for every sample"));
+		return false;
+	}
+
+	for (int32 Index = 1; Index < Times.Num(); ++Index)
+	{
+		if (!(Times[Index] > Times[Index - 1]))
+		{
+			MotionIntensityValidation::ReportError(EMotionIntensityError::InvalidInput, TEXT("Track times should strictly increase"));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool UMotionIntensityTrackFunctionLibrary::BakeMotionIntensityCurve(const TArray<FTransform>& Transforms,
+                                                                    const TArray<float>& Times,
+                                                                    const FMotionIntensityConfig& Config,
+                                                                    const FMotionIntensityCoefficients& Coefficients,
+                                                                    FRuntimeFloatCurve& OutCurve)
+{
+	if (!ValidateTrackTimes(Transforms, Times))
+	{
+		return false;
+	}
+
+	TArray<float> MotionIntensities;
+	MotionIntensities.SetNumUninitialized(Transforms.Num());
+
+	FMotionIntensityTrackEvaluator Evaluator(Config, Coefficients);
+	if (!Evaluator.EvaluateTrack(Transforms, Times, 0.0f, MotionIntensities))
+	{
+		return false;
+	}
+
+	FRichCurve& Curve = *OutCurve.GetRichCurve();
+	Curve.Reset();
+	Curve.Keys.Reserve(Transforms.Num());
+	for (int32 Index = 0; Index < Transforms.Num(); ++Index)
+	{
+		Curve.Keys.Emplace(Times[Index], MotionIntensities[Index]);
+	}
+	Curve.AutoSetTangents();
+
+	return true;
+}
+
+bool UMotionIntensityTrackFunctionLibrary::BakeMotionData(const TArray<FTransform>& Transforms,
+                                                          const TArray<float>& Times,
+                                                          const FMotionIntensityConfig& Config,
+                                                          const FMotionIntensityCoefficients& Coefficients,
+                                                          TArray<float>& OutMotionIntensities,
+                                                          TArray<FMotionIntensityMotionData>& OutMotionData)
+{
+	if (!ValidateTrackTimes(Transforms, Times))
+	{
+		return false;
+	}
+
+	OutMotionIntensities.SetNumUninitialized(Transforms.Num());
+	OutMotionData.SetNumUninitialized(Transforms.Num());
+
+	FMotionIntensityTrackEvaluator Evaluator(Config, Coefficients);
+	return Evaluator.EvaluateTrack(Transforms, Times, 0.0f, OutMotionIntensities, OutMotionData);
+}
@@ -0,0 +1,67 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityValidation.h"
+#include "MotionIntensityStats.h"
+#include "HAL/IConsoleManager.h"
+#include <atomic>
+
+static TAutoConsoleVariable<float> CVarMotionIntensityErrorLogInterval(
+	TEXT("MotionIntensity.ErrorLogInterval"),
+	5.0f,
+	TEXT("Minimum time in seconds between two logged errors of the same category, errors in between are only counted."));
+
+namespace
+{
+	struct FErrorCategory
+	{
+		std::atomic<int64> Count{0};
+		std::atomic<int64> Suppressed{0};
+		std::atomic<double> LastLogTime{-UE_BIG_NUMBER};
+	};
+
+	FErrorCategory ErrorCategories[static_cast<int32>(EMotionIntensityError::MAX)];
+}
+
+void MotionIntensityValidation::ReportError(const EMotionIntensityError Error, const TCHAR* Message)
+{
+	check(Error < EMotionIntensityError::MAX);
+	FErrorCategory& Category = ErrorCategories[static_cast<int32>(Error)];
+
+	Category.Count.fetch_add(1, std::memory_order_relaxed);
+	INC_DWORD_STAT(STAT_MotionIntensity_RejectedCalls);
+
+	// Only the thread that moves the last log time forward gets to log
+	const double Now = FPlatformTime::Seconds();
+	double LastLogTime = Category.LastLogTime.load(std::memory_order_relaxed);
+	if (Now - LastLogTime < CVarMotionIntensityErrorLogInterval.GetValueOnAnyThread()
+		|| !Category.LastLogTime.compare_exchange_strong(LastLogTime, Now, std::memory_order_relaxed))
+	{
+		Category.Suppressed.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	const int64 Suppressed = Category.Suppressed.exchange(0, std::memory_order_relaxed);
+	if (Suppressed > 0)
+	{
+		UE_LOG(MotionIntensityLog, Error, TEXT("%s (%lld more since the last report)"), Message, Suppressed);
+	}
+	else
+	{
+		UE_LOG(MotionIntensityLog, Error, TEXT("%s"), Message);
+	}
+}
+
+int64 MotionIntensityValidation::GetErrorCount(const EMotionIntensityError Error)
+{
+	check(Error < EMotionIntensityError::MAX);
+	return ErrorCategories[static_cast<int32>(Error)].Count.load(std::memory_order_relaxed);
+}
+
+void MotionIntensityValidation::ResetErrorCounts()
+{
+	for (FErrorCategory& Category : ErrorCategories)
+	{
+		Category.Count.store(0, std::memory_order_relaxed);
+		Category.Suppressed.store(0, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,139 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityWindowStats.h"
+
+/* Window stats */
+
+void FMotionIntensityWindowStats::AddSample(const float Value, const float DeltaTime)
+{
+	const int32 SafeCapacity = FMath::Max(1, Capacity);
+	if (Samples.Num() != SafeCapacity)
+	{
+		Samples.SetNumUninitialized(SafeCapacity);
+		SampleTimes.SetNumUninitialized(SafeCapacity);
+		MaxDeque.SetNumUninitialized(SafeCapacity);
+		Reset();
+	}
+
+	Clock += FMath::Max(0.0f, DeltaTime);
+
+	if (Count == SafeCapacity)
+	{
+		EvictOldest();
+	}
+
+	int32 Slot = Oldest + Count;
+	if (Slot >= SafeCapacity)
+	{
+		Slot -= SafeCapacity;
+	}
+	Samples[Slot] = Value;
+	SampleTimes[Slot] = Clock;
+	++Count;
+	Sum += Value;
+	SumOfSquares += static_cast<double>(Value) * Value;
+
+	// Samples not larger than the new one can never be the max again
+	while (DequeCount > 0)
+	{
+		int32 Last = DequeFront + DequeCount - 1;
+		if (Last >= SafeCapacity)
+		{
+			Last -= SafeCapacity;
+		}
+		if (Samples[MaxDeque[Last]] > Value)
+		{
+			break;
+		}
+		--DequeCount;
+	}
+	int32 Next = DequeFront + DequeCount;
+	if (Next >= SafeCapacity)
+	{
+		Next -= SafeCapacity;
+	}
+	MaxDeque[Next] = Slot;
+	++DequeCount;
+
+	// The newest sample always stays, so a long frame doesn't empty the window
+	if (WindowDuration > 0.0f)
+	{
+		while (Count > 1 && Clock - SampleTimes[Oldest] >= WindowDuration)
+		{
+			EvictOldest();
+		}
+	}
+}
+
+void FMotionIntensityWindowStats::Reset()
+{
+	Sum = 0.0;
+	SumOfSquares = 0.0;
+	Clock = 0.0;
+	Oldest = 0;
+	Count = 0;
+	DequeFront = 0;
+	DequeCount = 0;
+}
+
+float FMotionIntensityWindowStats::GetMean() const
+{
+	return Count > 0 ? static_cast<float>(Sum / Count) : 0.0f;
+}
+
+float FMotionIntensityWindowStats::GetRMS() const
+{
+	// Rounding of the running sum can leave it slightly below zero once large samples are evicted
+	return Count > 0 ? static_cast<float>(FMath::Sqrt(FMath::Max(0.0, SumOfSquares) / Count)) : 0.0f;
+}
+
+float FMotionIntensityWindowStats::GetMax() const
+{
+	return DequeCount > 0 ? Samples[MaxDeque[DequeFront]] : 0.0f;
+}
+
+void FMotionIntensityWindowStats::EvictOldest()
+{
+	const float Value = Samples[Oldest];
+	Sum -= Value;
+	SumOfSquares -= static_cast<double>(Value) * Value;
+
+	// Every slot is in the deque at most once, so the oldest sample can only be at its front
+	if (DequeCount > 0 && MaxDeque[DequeFront] == Oldest)
+	{
+		DequeFront = DequeFront + 1 < Samples.Num() ? DequeFront + 1 : 0;
+		--DequeCount;
+	}
+
+	Oldest = Oldest + 1 < Samples.Num() ? Oldest + 1 : 0;
+	--Count;
+}
+
+/* Blueprint library */
+
+void UMotionIntensityWindowStatsFunctionLibrary::AddWindowSample(FMotionIntensityWindowStats& WindowStats,
+                                                                 const float Value,
+                                                                 const float DeltaTime)
+{
+	WindowStats.AddSample(Value, DeltaTime);
+}
+
+void UMotionIntensityWindowStatsFunctionLibrary::ResetWindowStats(FMotionIntensityWindowStats& WindowStats)
+{
+	WindowStats.Reset();
+}
+
+float UMotionIntensityWindowStatsFunctionLibrary::GetWindowMean(const FMotionIntensityWindowStats& WindowStats)
+{
+	return WindowStats.GetMean();
+}
+
+float UMotionIntensityWindowStatsFunctionLibrary::GetWindowRMS(const FMotionIntensityWindowStats& WindowStats)
+{
+	return WindowStats.GetRMS();
+}
+
+float UMotionIntensityWindowStatsFunctionLibrary::GetWindowMax(const FMotionIntensityWindowStats& WindowStats)
+{
+	return WindowStats.GetMax();
+}
@@ -4,6 +4,7 @@
 
 #include "Modules/ModuleManager.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "MotionIntensityCore.h"
 #include "MotionIntensity.generated.h"
 
 class FMotionIntensityModule final : public IModuleInterface
@@ -15,6 +16,38 @@ public:
 
 DECLARE_LOG_CATEGORY_EXTERN(MotionIntensityLog, Log, All);
 
+// Categories of rejected calls, each one is counted and its log is rate limited separately
+UENUM(BlueprintType)
+enum class EMotionIntensityError : uint8
+{
+	// Delta Time isn't larger than zero, e.g. in a paused world
+	InvalidDeltaTime,
+	InvalidConfig,
+	InvalidCoefficients,
+	// Malformed arguments, e.g. a track without times or sample rate
+	InvalidInput,
+	MAX UMETA(Hidden)
+};
+
+// Smoothing of velocity and acceleration before they are differentiated into acceleration and jerk
+UENUM(BlueprintType)
+enum class EMotionIntensityFilter : uint8
+{
+	// Exponential smoothing like FInterpTo, the original behavior and the only filter with SIMD batch kernels
+	Exponential,
+	// Cutoff rises with the rate of change, smooth at rest with little lag in fast motion
+	OneEuro,
+	// Exact critically damped spring, differentiates without differencing noise
+	CriticallyDampedSpring,
+	// Second order Butterworth low-pass, steeper noise rejection for the same cutoff
+	Biquad
+};
+
+static_assert(static_cast<uint8>(EMotionIntensityFilter::Exponential) == static_cast<uint8>(MotionIntensityCore::EFilter::Exponential));
+static_assert(static_cast<uint8>(EMotionIntensityFilter::OneEuro) == static_cast<uint8>(MotionIntensityCore::EFilter::OneEuro));
+static_assert(static_cast<uint8>(EMotionIntensityFilter::CriticallyDampedSpring) == static_cast<uint8>(MotionIntensityCore::EFilter::CriticallyDampedSpring));
+static_assert(static_cast<uint8>(EMotionIntensityFilter::Biquad) == static_cast<uint8>(MotionIntensityCore::EFilter::Biquad));
+
 USTRUCT(BlueprintType)
 struct FMotionIntensityConfig
 {
@@ -78,6 +111,34 @@ struct FMotionIntensityConfig
 		meta = (EditCondition = "bCalculateAngularMotion", ClampMin = "0.01"))
 	float AngularAccelerationInterpolationSpeed = 10.0f;
 
+	// Filter used on velocity and acceleration, their interpolation speeds are its cutoff in rad/s
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Config")
+	EMotionIntensityFilter Filter = EMotionIntensityFilter::Exponential;
+
+	// How much the one-euro cutoff rises with the rate of change, 0 makes it a plain low-pass, must be >= 0.0f
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Config",
+		meta = (EditCondition = "Filter == EMotionIntensityFilter::OneEuro", ClampMin = "0.0"))
+	float OneEuroBeta = 0.5f;
+
+	// Cutoff in Hz of the rate of change the one-euro filter adapts to, must be > 0.0f
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Config",
+		meta = (EditCondition = "Filter == EMotionIntensityFilter::OneEuro", ClampMin = "0.01"))
+	float OneEuroDerivativeCutoff = 1.0f;
+
+	// If true, smoothing runs in fixed time steps regardless of Delta Time, so results don't depend on frame rate
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Config")
+	bool bUseFixedTimeStep = false;
+
+	// Fixed time step in seconds, must be > 0.0f
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Config",
+		meta = (EditCondition = "bUseFixedTimeStep", ClampMin = "0.001"))
+	float FixedTimeStep = 1.0f / 120.0f;
+
+	// Maximum number of fixed steps per update, longer frames stretch the steps instead of adding more, must be > 0
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Config",
+		meta = (EditCondition = "bUseFixedTimeStep", ClampMin = "1"))
+	int32 MaxSubsteps = 8;
+
 	bool IsValid() const
 	{
 		return MaxLinearVelocity > 0.0f
@@ -87,10 +148,75 @@ struct FMotionIntensityConfig
 			&& MaxAngularVelocity > 0.0f
 			&& RotationInterpolationSpeed > 0.0f
 			&& AngularVelocityInterpolationSpeed > 0.0f
-			&& AngularAccelerationInterpolationSpeed > 0.0f;
+			&& AngularAccelerationInterpolationSpeed > 0.0f
+			&& OneEuroBeta >= 0.0f
+			&& OneEuroDerivativeCutoff > 0.0f
+			&& (!bUseFixedTimeStep || (FixedTimeStep > 0.0f && MaxSubsteps > 0));
 	}
 };
 
+USTRUCT(BlueprintType)
+struct FMotionIntensityMotionData
+{
+	GENERATED_BODY()
+
+	// Normalized linear velocity
+	UPROPERTY(BlueprintReadOnly)
+	float LinearVelocityNormalized = 0.0f;
+
+	// Normalized positive linear acceleration
+	UPROPERTY(BlueprintReadOnly)
+	float PositiveLinearAccelerationNormalized = 0.0f;
+
+	// Normalized negative linear acceleration
+	UPROPERTY(BlueprintReadOnly)
+	float NegativeLinearAccelerationNormalized = 0.0f;
+
+	// Normalized positive linear jerk
+	UPROPERTY(BlueprintReadOnly)
+	float PositiveLinearJerkNormalized = 0.0f;
+
+	// Normalized negative linear jerk
+	UPROPERTY(BlueprintReadOnly)
+	float NegativeLinearJerkNormalized = 0.0f;
+
+	// Normalized angular velocity
+	UPROPERTY(BlueprintReadOnly)
+	float AngularVelocityNormalized = 0.0f;
+
+	// Normalized positive angular acceleration
+	UPROPERTY(BlueprintReadOnly)
+	float PositiveAngularAccelerationNormalized = 0.0f;
+
+	// Normalized negative angular acceleration
+	UPROPERTY(BlueprintReadOnly)
+	float NegativeAngularAccelerationNormalized = 0.0f;
+
+	// Normalized positive angular jerk
+	UPROPERTY(BlueprintReadOnly)
+	float PositiveAngularJerkNormalized = 0.0f;
+
+	// Normalized negative angular jerk
+	UPROPERTY(BlueprintReadOnly)
+	float NegativeAngularJerkNormalized = 0.0f;
+};
+
+// Memory of a smoothing filter beyond its previous output, what the fields hold depends on the filter
+USTRUCT(BlueprintType)
+struct FMotionIntensityFilterState
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite)
+	float Z1 = 0.0f;
+
+	UPROPERTY(BlueprintReadWrite)
+	float Z2 = 0.0f;
+
+	UPROPERTY(BlueprintReadWrite)
+	float Z3 = 0.0f;
+};
+
 USTRUCT(BlueprintType)
 struct FMotionIntensityServiceData
 {
@@ -132,6 +258,29 @@ struct FMotionIntensityServiceData
 	UPROPERTY(BlueprintReadWrite)
 	float PreviousAngularJerk = 0.0f;
 
+	// Filter memory of linear velocity smoothing
+	UPROPERTY(BlueprintReadWrite)
+	FMotionIntensityFilterState LinearVelocityFilterState;
+
+	// Filter memory of linear acceleration smoothing
+	UPROPERTY(BlueprintReadWrite)
+	FMotionIntensityFilterState LinearAccelerationFilterState;
+
+	// Filter memory of angular velocity smoothing
+	UPROPERTY(BlueprintReadWrite)
+	FMotionIntensityFilterState AngularVelocityFilterState;
+
+	// Filter memory of angular acceleration smoothing
+	UPROPERTY(BlueprintReadWrite)
+	FMotionIntensityFilterState AngularAccelerationFilterState;
+
+	// Time not yet consumed by fixed steps
+	UPROPERTY(BlueprintReadWrite)
+	float TimeAccumulator = 0.0f;
+
+	// Motion data of the last fixed step, returned again by updates too short to take a step
+	UPROPERTY(BlueprintReadWrite)
+	FMotionIntensityMotionData FixedStepMotionData;
 
 	void Reset()
 	{
@@ -144,55 +293,15 @@ struct FMotionIntensityServiceData
 		PreviousAngularVelocity = 0.0f;
 		PreviousAngularAcceleration = 0.0f;
 		PreviousAngularJerk = 0.0f;
+		LinearVelocityFilterState = FMotionIntensityFilterState();
+		LinearAccelerationFilterState = FMotionIntensityFilterState();
+		AngularVelocityFilterState = FMotionIntensityFilterState();
+		AngularAccelerationFilterState = FMotionIntensityFilterState();
+		TimeAccumulator = 0.0f;
+		FixedStepMotionData = FMotionIntensityMotionData();
 	}
 };
 
-USTRUCT(BlueprintType)
-struct FMotionIntensityMotionData
-{
-	GENERATED_BODY()
-
-	// Normalized linear velocity
-	UPROPERTY(BlueprintReadOnly)
-	float LinearVelocityNormalized = 0.0f;
-
-	// Normalized positive linear acceleration
-	UPROPERTY(BlueprintReadOnly)
-	float PositiveLinearAccelerationNormalized = 0.0f;
-
-	// Normalized negative linear acceleration
-	UPROPERTY(BlueprintReadOnly)
-	float NegativeLinearAccelerationNormalized = 0.0f;
-
-	// Normalized positive linear jerk
-	UPROPERTY(BlueprintReadOnly)
-	float PositiveLinearJerkNormalized = 0.0f;
-
-	// Normalized negative linear jerk
-	UPROPERTY(BlueprintReadOnly)
-	float NegativeLinearJerkNormalized = 0.0f;
-
-	// Normalized angular velocity
-	UPROPERTY(BlueprintReadOnly)
-	float AngularVelocityNormalized = 0.0f;
-
-	// Normalized positive angular acceleration
-	UPROPERTY(BlueprintReadOnly)
-	float PositiveAngularAccelerationNormalized = 0.0f;
-
-	// Normalized negative angular acceleration
-	UPROPERTY(BlueprintReadOnly)
-	float NegativeAngularAccelerationNormalized = 0.0f;
-
-	// Normalized positive angular jerk
-	UPROPERTY(BlueprintReadOnly)
-	float PositiveAngularJerkNormalized = 0.0f;
-
-	// Normalized negative angular jerk
-	UPROPERTY(BlueprintReadOnly)
-	float NegativeAngularJerkNormalized = 0.0f;
-};
-
 USTRUCT(BlueprintType)
 struct FMotionIntensityCoefficients
 {
@@ -257,6 +366,51 @@ struct FMotionIntensityCoefficients
 	}
 };
 
+// Coefficients resolved once for the hot path: validated, squared and normalized, so evaluating them costs a dot product
+// and a square root. Build it once from coefficients or a preset and evaluate every frame.
+USTRUCT(BlueprintType)
+struct FMotionIntensityCompiledCoefficients
+{
+	GENERATED_BODY()
+
+	FMotionIntensityCompiledCoefficients() = default;
+
+	explicit FMotionIntensityCompiledCoefficients(const FMotionIntensityCoefficients& Coefficients)
+		: Compiled(MotionIntensityCore::CompileCoefficients(Coefficients))
+	{
+	}
+
+	// False if the coefficients it was built from are invalid or if it's default-constructed
+	bool IsValid() const
+	{
+		return Compiled.bIsValid;
+	}
+
+	float GetLinearMotionIntensity(const FMotionIntensityMotionData& MotionData) const
+	{
+		return MotionIntensityCore::GetLinearMotionIntensityFromMotionData(MotionData, Compiled);
+	}
+
+	float GetAngularMotionIntensity(const FMotionIntensityMotionData& MotionData) const
+	{
+		return MotionIntensityCore::GetAngularMotionIntensityFromMotionData(MotionData, Compiled);
+	}
+
+	float GetMotionIntensity(const FMotionIntensityMotionData& MotionData) const
+	{
+		return MotionIntensityCore::GetMotionIntensityFromMotionData(MotionData, Compiled);
+	}
+
+	// Same as above for the packed motion data native batches work with
+	float GetMotionIntensity(const MotionIntensityCore::FPackedMotionData& MotionData) const
+	{
+		return MotionIntensityCore::GetMotionIntensityFromMotionData(MotionData, Compiled);
+	}
+
+private:
+	MotionIntensityCore::FCompiledCoefficients Compiled;
+};
+
 UCLASS(meta=(BlueprintThreadSafe))
 class UMotionIntensityFunctionLibrary : public UBlueprintFunctionLibrary
 {
@@ -290,7 +444,8 @@ public:
 		UPARAM(DisplayName = "Motion Data") const FMotionIntensityMotionData& MotionData,
 		UPARAM(DisplayName = "Coefficients") const FMotionIntensityCoefficients& Coefficients);
 
-	// Calculates overall motion intensity based on the transform, config, and coefficients
+	// Calculates overall motion intensity based on the transform, config, and coefficients.
+	// Service Data advances even if the coefficients are invalid, motion intensity is 0 then.
 	UFUNCTION(BlueprintCallable)
 	static UPARAM(DisplayName = "Motion Intensity") float GetMotionIntensity(
 		UPARAM(DisplayName = "Current Location") const FVector Location,
@@ -300,6 +455,50 @@ public:
 		UPARAM(ref, DisplayName = "Service Data") FMotionIntensityServiceData& ServiceData,
 		UPARAM(DisplayName = "Coefficients") const FMotionIntensityCoefficients& Coefficients);
 
+	// Calculates motion data from velocities instead of the transform, e.g. physics or movement component velocity.
+	// Cheaper and one smoothing stage ahead of CalculateMotionData, previous transform in Service Data is left untouched
+	UFUNCTION(BlueprintCallable)
+	static UPARAM(DisplayName = "Motion Data") FMotionIntensityMotionData CalculateMotionDataFromVelocity(
+		UPARAM(DisplayName = "Linear Velocity") const FVector LinearVelocity,
+		UPARAM(DisplayName = "Angular Velocity (rad/s)") const FVector AngularVelocity,
+		UPARAM(DisplayName = "Delta Time") float DeltaTime,
+		UPARAM(DisplayName = "Config") const FMotionIntensityConfig& Config,
+		UPARAM(ref, DisplayName = "Service Data") FMotionIntensityServiceData& ServiceData);
+
+	// Calculates overall motion intensity from velocities, config, and coefficients.
+	// Service Data advances even if the coefficients are invalid, motion intensity is 0 then.
+	UFUNCTION(BlueprintCallable)
+	static UPARAM(DisplayName = "Motion Intensity") float GetMotionIntensityFromVelocity(
+		UPARAM(DisplayName = "Linear Velocity") const FVector LinearVelocity,
+		UPARAM(DisplayName = "Angular Velocity (rad/s)") const FVector AngularVelocity,
+		UPARAM(DisplayName = "Delta Time") float DeltaTime,
+		UPARAM(DisplayName = "Config") const FMotionIntensityConfig& Config,
+		UPARAM(ref, DisplayName = "Service Data") FMotionIntensityServiceData& ServiceData,
+		UPARAM(DisplayName = "Coefficients") const FMotionIntensityCoefficients& Coefficients);
+
+	// Resolves coefficients once into the form the compiled overloads below evaluate
+	UFUNCTION(BlueprintCallable)
+	static UPARAM(DisplayName = "Compiled Coefficients") FMotionIntensityCompiledCoefficients CompileCoefficients(
+		UPARAM(DisplayName = "Coefficients") const FMotionIntensityCoefficients& Coefficients);
+
+	// Calculates linear motion intensity from motion data and compiled coefficients
+	UFUNCTION(BlueprintCallable)
+	static UPARAM(DisplayName = "Linear Motion Intensity") float GetLinearMotionIntensityFromMotionDataCompiled(
+		UPARAM(DisplayName = "Motion Data") const FMotionIntensityMotionData& MotionData,
+		UPARAM(DisplayName = "Compiled Coefficients") const FMotionIntensityCompiledCoefficients& CompiledCoefficients);
+
+	// Calculates angular motion intensity from motion data and compiled coefficients
+	UFUNCTION(BlueprintCallable)
+	static UPARAM(DisplayName = "Angular Motion Intensity") float GetAngularMotionIntensityFromMotionDataCompiled(
+		UPARAM(DisplayName = "Motion Data") const FMotionIntensityMotionData& MotionData,
+		UPARAM(DisplayName = "Compiled Coefficients") const FMotionIntensityCompiledCoefficients& CompiledCoefficients);
+
+	// Calculates overall motion intensity from motion data and compiled coefficients
+	UFUNCTION(BlueprintCallable)
+	static UPARAM(DisplayName = "Motion Intensity") float GetMotionIntensityFromMotionDataCompiled(
+		UPARAM(DisplayName = "Motion Data") const FMotionIntensityMotionData& MotionData,
+		UPARAM(DisplayName = "Compiled Coefficients") const FMotionIntensityCompiledCoefficients& CompiledCoefficients);
+
 	// Resets Service Data to its initial state
 	UFUNCTION(BlueprintCallable)
 	static void ResetServiceData(
@@ -308,37 +507,18 @@ public:
 		ServiceData.Reset();
 	}
 
-private:
-	static float GetSmoothedDerivative(const float Current,
-	                                   float& OutPrevious,
-	                                   const float DeltaTime,
-	                                   const float InterpolationSpeed);
-
-	static float GetLinearVelocitySmoothed(const FVector& Current,
-	                                       FVector& OutPrevious,
-	                                       float DeltaTime,
-	                                       float InterpolationSpeed);
-
-	static float GetAngularVelocitySmoothed(const FQuat& Current,
-	                                        FQuat& OutPrevious,
-	                                        float DeltaTime,
-	                                        float InterpolationSpeed);
-
-	static void CalculateLinearMotionData(const FVector& CurrentLocation,
-	                                      const float DeltaTime,
-	                                      const FMotionIntensityConfig& Config,
-	                                      FMotionIntensityServiceData& ServiceData,
-	                                      FMotionIntensityMotionData& OutMotionData);
-
-	static void CalculateAngularMotionData(const FQuat& CurrentRotation,
-	                                       const float DeltaTime,
-	                                       const FMotionIntensityConfig& Config,
-	                                       FMotionIntensityServiceData& ServiceData,
-	                                       FMotionIntensityMotionData& OutMotionData);
+	// Number of rejected calls in the category since startup or the last reset, counted even when logging is rate limited
+	UFUNCTION(BlueprintCallable)
+	static UPARAM(DisplayName = "Error Count") int64 GetErrorCount(
+		UPARAM(DisplayName = "Error") EMotionIntensityError Error);
+
+	// Resets error counts of all categories
+	UFUNCTION(BlueprintCallable)
+	static void ResetErrorCounts();
 };
 
 UCLASS(BlueprintType)
-class UMotionIntensityPreset : public UDataAsset
+class MOTIONINTENSITY_API UMotionIntensityPreset : public UDataAsset
 {
 	GENERATED_BODY()
 
@@ -348,4 +528,11 @@ public:
 
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Coefficients", meta=(ShowOnlyInnerProperties))
 	FMotionIntensityCoefficients Coefficients;
+
+	// Coefficients of this preset resolved for the hot path, rebuild it if the coefficients change
+	UFUNCTION(BlueprintPure, Category = "Coefficients")
+	FMotionIntensityCompiledCoefficients CompileCoefficients() const
+	{
+		return FMotionIntensityCompiledCoefficients(Coefficients);
+	}
 };
@@ -0,0 +1,117 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "Animation/AnimNodeBase.h"
+#include "Animation/AnimNodeReference.h"
+#include "BoneContainer.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "MotionIntensity.h"
+#include "MotionIntensityAnimNode.generated.h"
+
+// What the anim node tracks
+UENUM(BlueprintType)
+enum class EMotionIntensityAnimSource : uint8
+{
+	// A bone of the pose passing through the node, sampled when the pose is evaluated. Evaluation runs after every
+	// update and On Update node function, so node functions read the results of a bone one update late.
+	Bone,
+	// World transform of the skeletal mesh component as captured when the update started, sampled on update.
+	// Root motion extracted by the update itself only moves the component after it, so it shows up in the next update.
+	ComponentTransform
+};
+
+// Tracks the motion intensity of a bone or of the mesh on the animation worker threads, passing its pose through.
+// Results are read with the node functions of UMotionIntensityAnimNodeLibrary: results of the component transform are
+// calculated during the update and can be read in the same one, results of a bone are one update behind.
+USTRUCT(BlueprintInternalUseOnly)
+struct MOTIONINTENSITY_API FAnimNode_MotionIntensity : public FAnimNode_Base
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Links")
+	FPoseLink Source;
+
+	UPROPERTY(EditAnywhere, Category = "Motion Intensity")
+	EMotionIntensityAnimSource SampleSource = EMotionIntensityAnimSource::Bone;
+
+	UPROPERTY(EditAnywhere, Category = "Motion Intensity", meta = (EditCondition = "SampleSource == EMotionIntensityAnimSource::Bone"))
+	FBoneReference Bone;
+
+	// If true, the bone is tracked in world space, so moving the whole mesh counts.
+	// Otherwise it's tracked relative to the mesh, e.g. to isolate animation from locomotion.
+	UPROPERTY(EditAnywhere, Category = "Motion Intensity", meta = (EditCondition = "SampleSource == EMotionIntensityAnimSource::Bone"))
+	bool bWorldSpace = false;
+
+	// Config and coefficients, defaults are used if not set
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Intensity", meta = (PinHiddenByDefault))
+	TObjectPtr<UMotionIntensityPreset> Preset;
+
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
+	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+
+	// Resets service data, next sample will start from the current transform
+	void ResetMotionIntensity();
+
+	// Motion data from the latest sample
+	const FMotionIntensityMotionData& GetMotionData() const
+	{
+		return MotionData;
+	}
+
+	// Overall motion intensity from the latest sample
+	float GetMotionIntensity() const
+	{
+		return MotionIntensity;
+	}
+
+private:
+	void Sample(const FTransform& Transform, float DeltaTime);
+
+	FMotionIntensityServiceData ServiceData;
+	FMotionIntensityMotionData MotionData;
+	float MotionIntensity = 0.0f;
+
+	// Time updated since the bone was last sampled, poses aren't evaluated on every update
+	float PendingDeltaTime = 0.0f;
+};
+
+USTRUCT(BlueprintType)
+struct FMotionIntensityAnimNodeReference : public FAnimNodeReference
+{
+	GENERATED_BODY()
+
+	typedef FAnimNode_MotionIntensity FInternalNodeType;
+};
+
+// Node functions of the Motion Intensity anim node, e.g. to drive the alpha of an additive layer from its On Update
+UCLASS(meta=(BlueprintThreadSafe))
+class MOTIONINTENSITY_API UMotionIntensityAnimNodeLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Gets a Motion Intensity node from an anim node reference
+	UFUNCTION(BlueprintCallable, meta = (ExpandEnumAsExecs = "Result"))
+	static UPARAM(DisplayName = "Motion Intensity Node") FMotionIntensityAnimNodeReference ConvertToMotionIntensityNode(
+		UPARAM(DisplayName = "Node") const FAnimNodeReference& Node,
+		UPARAM(DisplayName = "Result") EAnimNodeReferenceConversionResult& Result);
+
+	// Motion data of the node from its latest sample
+	UFUNCTION(BlueprintPure)
+	static UPARAM(DisplayName = "Motion Data") FMotionIntensityMotionData GetAnimNodeMotionData(
+		UPARAM(DisplayName = "Motion Intensity Node") const FMotionIntensityAnimNodeReference& Node);
+
+	// Overall motion intensity of the node from its latest sample
+	UFUNCTION(BlueprintPure)
+	static UPARAM(DisplayName = "Motion Intensity") float GetAnimNodeMotionIntensity(
+		UPARAM(DisplayName = "Motion Intensity Node") const FMotionIntensityAnimNodeReference& Node);
+
+	// Resets the node, its next sample will start from the current transform
+	UFUNCTION(BlueprintCallable)
+	static void ResetAnimNodeMotionIntensity(
+		UPARAM(DisplayName = "Motion Intensity Node") const FMotionIntensityAnimNodeReference& Node);
+};
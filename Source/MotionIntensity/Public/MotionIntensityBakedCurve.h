@@ -0,0 +1,73 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "Engine/DataAsset.h"
+#include "MotionIntensity.h"
+#include "MotionIntensityBakedCurve.generated.h"
+
+UENUM(BlueprintType)
+enum class EMotionIntensityQuantization : uint8
+{
+	// One byte per sample
+	EightBit,
+	// Two bytes per sample
+	SixteenBit
+};
+
+// Precomputed motion intensity of a sequence, uniformly sampled and quantized.
+// Looking it up is a single interpolation, so canned content doesn't need to run the smoothing chain every frame.
+UCLASS(BlueprintType)
+class MOTIONINTENSITY_API UMotionIntensityBakedCurve : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Returns motion intensity at the given time in seconds, linearly interpolated between samples.
+	// Looping wraps the time with the period of GetDuration(), so the last sample of a loop should match the first.
+	UFUNCTION(BlueprintPure, Category = "Motion Intensity", meta = (BlueprintThreadSafe))
+	float Evaluate(float Time, bool bLoop = false) const;
+
+	// Duration of the baked sequence in seconds
+	UFUNCTION(BlueprintPure, Category = "Motion Intensity", meta = (BlueprintThreadSafe))
+	float GetDuration() const;
+
+	// Bakes a transform track sampled uniformly at the given rate, returns false if nothing was baked
+	UFUNCTION(BlueprintCallable, Category = "Motion Intensity")
+	bool Bake(const TArray<FTransform>& Transforms,
+	          float InSampleRate,
+	          const FMotionIntensityConfig& Config,
+	          const FMotionIntensityCoefficients& Coefficients,
+	          EMotionIntensityQuantization InQuantization = EMotionIntensityQuantization::EightBit);
+
+	// Replaces the samples with already evaluated motion intensities sampled uniformly at the given rate
+	void SetSamples(TArrayView<const float> MotionIntensities,
+	                float InSampleRate,
+	                EMotionIntensityQuantization InQuantization);
+
+	int32 NumSamples() const
+	{
+		return Quantization == EMotionIntensityQuantization::EightBit ? EightBitSamples.Num() : SixteenBitSamples.Num();
+	}
+
+protected:
+	// Samples per second
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Motion Intensity")
+	float SampleRate = 30.0f;
+
+	// Value of the largest quantized sample
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Motion Intensity")
+	float Scale = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Motion Intensity")
+	EMotionIntensityQuantization Quantization = EMotionIntensityQuantization::EightBit;
+
+	UPROPERTY()
+	TArray<uint8> EightBitSamples;
+
+	UPROPERTY()
+	TArray<uint16> SixteenBitSamples;
+
+private:
+	float GetSample(int32 Index) const;
+};
@@ -0,0 +1,254 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "MotionIntensity.h"
+#include "MotionIntensityCore.h"
+
+class FMotionIntensityBatchSnapshot;
+
+// Service data of many objects stored as structure of arrays, evaluated with one shared config and coefficients.
+// Meant for native code that tracks thousands of objects per tick, where per-call overhead of the library dominates.
+// Large batches are split into fixed-size chunks evaluated with ParallelFor, see MotionIntensity.Batch.* console variables.
+// State is kept in a compact single precision layout, locations relative to the origin of the batch and acceleration and
+// jerk as signed values, 45 bytes per object with the exponential filter against about 180 for Service Data. It's expanded
+// only when it leaves the batch. Filter states, fixed step state and the last inputs of indexed evaluation take up to
+// 104 bytes more, they're allocated for all entries the first time a config or an evaluation needs them.
+// The origin follows the objects, see MotionIntensity.Batch.MaxOriginDistance, so they stay precise anywhere in a large
+// world as long as one batch doesn't span more than a few kilometers.
+class MOTIONINTENSITY_API FMotionIntensityBatch
+{
+public:
+	// Adds a new entry in its initial state and returns its index
+	int32 Add();
+
+	// Removes the entry at the given index, the last entry is moved into its place
+	void RemoveAtSwap(int32 Index);
+
+	// Resets the entry at the given index to its initial state
+	void ResetEntry(int32 Index);
+
+	// Removes all entries
+	void Empty();
+
+	// Reserves memory for the given number of entries
+	void Reserve(int32 Number);
+
+	// Number of entries
+	int32 Num() const
+	{
+		return PreviousLocations.Num();
+	}
+
+	bool IsValidIndex(const int32 Index) const
+	{
+		return PreviousLocations.IsValidIndex(Index);
+	}
+
+	// Stored locations are relative to the origin, evaluation moves it to the center of the objects when they drift away
+	const FVector& GetOrigin() const
+	{
+		return Origin;
+	}
+
+	// Moves the origin, stored locations are rebased so entries continue smoothly
+	void SetOrigin(const FVector& NewOrigin);
+
+	// Moves stored locations along with the world when its origin is rebased, so entries don't see the shift as motion.
+	// Only the origin moves, which is exact and doesn't touch the entries.
+	void ApplyWorldOffset(const FVector& InOffset)
+	{
+		Origin += InOffset;
+	}
+
+	// Saves the state of all entries, see FMotionIntensityBatchHistory to keep one per frame. Only allocated state is saved.
+	void SaveSnapshot(FMotionIntensityBatchSnapshot& OutSnapshot) const;
+
+	// Restores the state of all entries, the number of entries becomes the one of the snapshot
+	void RestoreSnapshot(const FMotionIntensityBatchSnapshot& Snapshot);
+
+	// Copies the entry at the given index out into a regular Service Data struct
+	FMotionIntensityServiceData GetServiceData(int32 Index) const;
+
+	// Overwrites the entry at the given index with a regular Service Data struct. Filter states and fixed step state the
+	// batch hasn't allocated yet are dropped, filters start settled at the smoothed values once they're needed.
+	void SetServiceData(int32 Index, const FMotionIntensityServiceData& ServiceData);
+
+	// Calculates motion data for every entry, inputs and output must have Num() elements.
+	// Returns false and leaves the output untouched if Delta Time or config are invalid.
+	// Output is written from worker threads when the batch is evaluated in parallel.
+	bool CalculateMotionData(TArrayView<const FVector> Locations,
+	                         TArrayView<const FQuat> Rotations,
+	                         float DeltaTime,
+	                         const FMotionIntensityConfig& Config,
+	                         TArrayView<FMotionIntensityMotionData> OutMotionData);
+
+	// Calculates overall motion intensity for every entry, inputs and output must have Num() elements.
+	// Returns false and leaves the output untouched if Delta Time, config or coefficients are invalid.
+	bool GetMotionIntensity(TArrayView<const FVector> Locations,
+	                        TArrayView<const FQuat> Rotations,
+	                        float DeltaTime,
+	                        const FMotionIntensityConfig& Config,
+	                        const FMotionIntensityCoefficients& Coefficients,
+	                        TArrayView<float> OutMotionIntensities);
+
+	// Same as above, also writes the motion data every intensity was calculated from
+	bool GetMotionIntensity(TArrayView<const FVector> Locations,
+	                        TArrayView<const FQuat> Rotations,
+	                        float DeltaTime,
+	                        const FMotionIntensityConfig& Config,
+	                        const FMotionIntensityCoefficients& Coefficients,
+	                        TArrayView<FMotionIntensityMotionData> OutMotionData,
+	                        TArrayView<float> OutMotionIntensities);
+
+	// Same as above with coefficients compiled ahead of time
+	bool GetMotionIntensity(TArrayView<const FVector> Locations,
+	                        TArrayView<const FQuat> Rotations,
+	                        float DeltaTime,
+	                        const FMotionIntensityConfig& Config,
+	                        const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+	                        TArrayView<float> OutMotionIntensities);
+
+	bool GetMotionIntensity(TArrayView<const FVector> Locations,
+	                        TArrayView<const FQuat> Rotations,
+	                        float DeltaTime,
+	                        const FMotionIntensityConfig& Config,
+	                        const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+	                        TArrayView<FMotionIntensityMotionData> OutMotionData,
+	                        TArrayView<float> OutMotionIntensities);
+
+	// Calculates motion data for every entry from velocities instead of transforms, e.g. of physics bodies or movement
+	// components. Cheaper and one smoothing stage ahead, previous transforms of the entries are left untouched.
+	// Angular velocities are in radians per second, inputs and output must have Num() elements.
+	bool CalculateMotionDataFromVelocity(TArrayView<const FVector> LinearVelocities,
+	                                     TArrayView<const FVector> AngularVelocities,
+	                                     float DeltaTime,
+	                                     const FMotionIntensityConfig& Config,
+	                                     TArrayView<FMotionIntensityMotionData> OutMotionData);
+
+	// Same as above, also calculates overall motion intensity, motion data output is optional
+	bool GetMotionIntensityFromVelocity(TArrayView<const FVector> LinearVelocities,
+	                                    TArrayView<const FVector> AngularVelocities,
+	                                    float DeltaTime,
+	                                    const FMotionIntensityConfig& Config,
+	                                    const FMotionIntensityCoefficients& Coefficients,
+	                                    TArrayView<FMotionIntensityMotionData> OutMotionData,
+	                                    TArrayView<float> OutMotionIntensities);
+
+	// Same as above with coefficients compiled ahead of time
+	bool GetMotionIntensityFromVelocity(TArrayView<const FVector> LinearVelocities,
+	                                    TArrayView<const FVector> AngularVelocities,
+	                                    float DeltaTime,
+	                                    const FMotionIntensityConfig& Config,
+	                                    const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+	                                    TArrayView<FMotionIntensityMotionData> OutMotionData,
+	                                    TArrayView<float> OutMotionIntensities);
+
+	// Calculates overall motion intensity for the given entries only, each advancing by its own time over its own
+	// number of frames, see FMotionIntensityScheduler. Indices must be valid and distinct, listed entries are evaluated in
+	// parallel. Times and frames are indexed like the batch and must be > 0 for every listed entry.
+	// Entries retrace a straight path from the transform they were last evaluated with by this overload, so don't mix it
+	// with the others on the same batch. Outputs are indexed like the batch, entries not listed are left untouched.
+	// Returns false and leaves the batch untouched if any listed Delta Time or frame count, config or coefficients are invalid.
+	bool GetMotionIntensity(TArrayView<const int32> Indices,
+	                        TArrayView<const FVector> Locations,
+	                        TArrayView<const FQuat> Rotations,
+	                        TArrayView<const float> DeltaTimes,
+	                        TArrayView<const int32> Frames,
+	                        const FMotionIntensityConfig& Config,
+	                        const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+	                        TArrayView<FMotionIntensityMotionData> OutMotionData,
+	                        TArrayView<float> OutMotionIntensities);
+
+	// Replays consecutive frames from the current state, e.g. after restoring a snapshot for a rollback.
+	// Locations and rotations hold the frames one after another with Num() elements each, Delta Times hold one time per
+	// frame. Every parallel chunk of entries runs through all frames, so the whole replay is a single parallel dispatch.
+	// Outputs have Num() elements and receive the last frame.
+	// Returns false and leaves the batch untouched if any Delta Time, config or coefficients are invalid.
+	bool Resimulate(TArrayView<const FVector> Locations,
+	                TArrayView<const FQuat> Rotations,
+	                TArrayView<const float> DeltaTimes,
+	                const FMotionIntensityConfig& Config,
+	                const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+	                TArrayView<FMotionIntensityMotionData> OutMotionData,
+	                TArrayView<float> OutMotionIntensities);
+
+private:
+	// State only some evaluations need
+	enum EOptionalState : uint8
+	{
+		FilterState = 1 << 0,
+		FixedStepState = 1 << 1,
+		PreviousInputState = 1 << 2
+	};
+
+	// Allocates the state the config needs along with the given optional state, if the batch doesn't have it yet
+	void AllocateState(const FMotionIntensityConfig& Config, uint8 State = 0);
+
+	// Calls Function on every allocated state array, in the order of the members
+	template <typename BatchType, typename FunctionType>
+	static void ForEachStateArray(BatchType& Batch, FunctionType&& Function);
+
+	// Same as above for the arrays of the given optional state only
+	template <typename BatchType, typename FunctionType>
+	static void ForEachOptionalStateArray(BatchType& Batch, uint8 State, FunctionType&& Function);
+
+	// Bytes of allocated state per entry
+	int32 GetEntrySize() const;
+
+	static bool ValidateInputs(float DeltaTime, const FMotionIntensityConfig& Config);
+
+	bool ValidateIndexedInputs(TArrayView<const int32> Indices,
+	                           TArrayView<const float> DeltaTimes,
+	                           TArrayView<const int32> Frames,
+	                           const FMotionIntensityConfig& Config) const;
+
+	MotionIntensityCore::TBatchView<FVector, FQuat> GetView();
+
+	template <typename OutputFunctionType>
+	void Evaluate(TArrayView<const FVector> Locations,
+	              TArrayView<const FQuat> Rotations,
+	              float DeltaTime,
+	              const FMotionIntensityConfig& Config,
+	              OutputFunctionType&& OutputFunction);
+
+	template <typename OutputFunctionType>
+	void EvaluateFromVelocity(TArrayView<const FVector> LinearVelocities,
+	                          TArrayView<const FVector> AngularVelocities,
+	                          float DeltaTime,
+	                          const FMotionIntensityConfig& Config,
+	                          OutputFunctionType&& OutputFunction);
+
+	// Moves the origin to the center of the given locations once it's farther than MotionIntensity.Batch.MaxOriginDistance
+	template <typename LocationFunctionType>
+	void FollowLocations(int32 Number, LocationFunctionType&& GetLocation);
+
+	// Calls RangeFunction(Begin, End) over [0, Number), in parallel chunks for large numbers
+	template <typename RangeFunctionType>
+	static void EvaluateRanges(int32 Number, RangeFunctionType&& RangeFunction);
+
+	// Cache line aligned, so fixed-size parallel chunks never share a line
+	template <typename ElementType>
+	using TChunkedArray = TArray<ElementType, TAlignedHeapAllocator<PLATFORM_CACHE_LINE_SIZE>>;
+
+	FVector Origin = FVector::ZeroVector;
+
+	// Combination of EOptionalState, the arrays of the optional state that isn't allocated are empty
+	uint8 OptionalState = 0;
+
+	TChunkedArray<bool> SetPreviousTransformToCurrent;
+	TChunkedArray<MotionIntensityCore::FFloatVector3> PreviousLocations;
+	TChunkedArray<MotionIntensityCore::FFloatQuat4> PreviousRotations;
+	TChunkedArray<float> PreviousLinearVelocities;
+	TChunkedArray<float> PreviousLinearAccelerations;
+	TChunkedArray<float> PreviousAngularVelocities;
+	TChunkedArray<float> PreviousAngularAccelerations;
+	TChunkedArray<MotionIntensityCore::FFilterState> LinearVelocityFilterStates;
+	TChunkedArray<MotionIntensityCore::FFilterState> LinearAccelerationFilterStates;
+	TChunkedArray<MotionIntensityCore::FFilterState> AngularVelocityFilterStates;
+	TChunkedArray<MotionIntensityCore::FFilterState> AngularAccelerationFilterStates;
+	TChunkedArray<float> TimeAccumulators;
+	TChunkedArray<MotionIntensityCore::FPackedMotionData> FixedStepMotionData;
+	TChunkedArray<MotionIntensityCore::FFloatVector3> PreviousInputLocations;
+	TChunkedArray<MotionIntensityCore::FFloatQuat4> PreviousInputRotations;
+};
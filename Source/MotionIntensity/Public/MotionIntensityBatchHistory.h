@@ -0,0 +1,75 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "MotionIntensityBatch.h"
+
+// State of a whole batch at one point in time, e.g. for rollback or replays. Holds the batch's allocated compact state
+// arrays back to back, every one of them trivially copyable, so saving and restoring costs one memcpy per array.
+// Keeps its allocation when saved into again.
+class MOTIONINTENSITY_API FMotionIntensityBatchSnapshot
+{
+public:
+	// Number of entries
+	int32 Num() const
+	{
+		return NumEntries;
+	}
+
+	const FVector& GetOrigin() const
+	{
+		return Origin;
+	}
+
+	// Bytes of state per entry, depends on the state the batch had allocated
+	int32 GetEntrySize() const
+	{
+		return NumEntries > 0 ? Data.Num() / NumEntries : 0;
+	}
+
+private:
+	friend class FMotionIntensityBatch;
+
+	FVector Origin = FVector::ZeroVector;
+	int32 NumEntries = 0;
+	uint8 OptionalState = 0;
+	TArray<uint8> Data;
+};
+
+// Snapshots of the latest frames of a batch in a ring, one per frame. Once the ring is full, recording a frame reuses
+// the allocation of the oldest one, so rolling back and resimulating every frame doesn't allocate.
+class MOTIONINTENSITY_API FMotionIntensityBatchHistory
+{
+public:
+	// Depth is the number of latest frames kept
+	explicit FMotionIntensityBatchHistory(int32 InDepth = 64);
+
+	int32 GetDepth() const
+	{
+		return Snapshots.Num();
+	}
+
+	// Changing the depth empties the history
+	void SetDepth(int32 NewDepth);
+
+	// Saves the batch as its state at the end of the given frame, frames are numbered from zero
+	void Record(const FMotionIntensityBatch& Batch, int32 Frame);
+
+	// Snapshot of the given frame, null if it wasn't recorded or is older than the depth
+	const FMotionIntensityBatchSnapshot* Find(int32 Frame) const;
+
+	// Restores the batch to its state at the end of the given frame, returns false if the frame isn't kept
+	bool Restore(FMotionIntensityBatch& Batch, int32 Frame) const;
+
+	// Forgets frames after the given one, e.g. after a rollback to it
+	void DiscardAfter(int32 Frame);
+
+	// Forgets all frames, keeps the allocations
+	void Empty();
+
+private:
+	TArray<FMotionIntensityBatchSnapshot> Snapshots;
+
+	// Frame every snapshot holds, INDEX_NONE if it holds none
+	TArray<int32> Frames;
+};
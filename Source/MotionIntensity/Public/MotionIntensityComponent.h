@@ -0,0 +1,154 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "MotionIntensity.h"
+#include "MotionIntensityReplication.h"
+#include "MotionIntensityThreshold.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "MotionIntensityComponent.generated.h"
+
+class USceneComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMotionIntensityThresholdSignature, FName, ThresholdName);
+
+// Tracks the motion intensity of a scene component.
+// Doesn't tick by itself, all components in a world are evaluated in one batch by UMotionIntensitySubsystem in TG_PostPhysics.
+UCLASS(ClassGroup = (MotionIntensity), meta = (BlueprintSpawnableComponent))
+class MOTIONINTENSITY_API UMotionIntensityComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMotionIntensityComponent();
+
+	// Sets the preset, components sharing a preset are evaluated together
+	UFUNCTION(BlueprintCallable, Category = "Motion Intensity")
+	void SetPreset(UMotionIntensityPreset* NewPreset);
+
+	UFUNCTION(BlueprintPure, Category = "Motion Intensity")
+	UMotionIntensityPreset* GetPreset() const
+	{
+		return Preset;
+	}
+
+	// Sets the scene component whose transform is tracked, the owner's root component is used if not set
+	UFUNCTION(BlueprintCallable, Category = "Motion Intensity")
+	void SetTrackedComponent(USceneComponent* NewTrackedComponent);
+
+	// Scene component whose transform is tracked
+	UFUNCTION(BlueprintPure, Category = "Motion Intensity")
+	USceneComponent* GetTrackedComponent() const;
+
+	// Resets service data, next update will start from the current transform
+	UFUNCTION(BlueprintCallable, Category = "Motion Intensity")
+	void ResetMotionIntensity();
+
+	// True between the enter and exit events of the threshold, false if there's no threshold with this name
+	UFUNCTION(BlueprintPure, Category = "Motion Intensity|Thresholds")
+	bool IsThresholdActive(FName ThresholdName) const;
+
+	// Motion data from the latest update
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Motion Intensity")
+	FMotionIntensityMotionData MotionData;
+
+	// Overall motion intensity from the latest update
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Motion Intensity")
+	float MotionIntensity = 0.0f;
+
+	// Watched after every update, their events fire only on transitions, so consumers don't have to poll every frame
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Motion Intensity|Thresholds")
+	TArray<FMotionIntensityThreshold> Thresholds;
+
+	// Fires once a threshold enters, after all components of the world are updated
+	UPROPERTY(BlueprintAssignable, Category = "Motion Intensity|Thresholds")
+	FMotionIntensityThresholdSignature OnThresholdEntered;
+
+	// Fires once a threshold exits, after all components of the world are updated
+	UPROPERTY(BlueprintAssignable, Category = "Motion Intensity|Thresholds")
+	FMotionIntensityThresholdSignature OnThresholdExited;
+
+	// If true, motion intensity is traced as a counter track visible in Unreal Insights, meant for a few selected objects
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, AdvancedDisplay, Category = "Motion Intensity")
+	bool bTraceMotionIntensity = false;
+
+	// If true, the server's motion intensity is replicated and corrects the local evaluation on clients.
+	// Must be set before BeginPlay, the owner has to replicate.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Motion Intensity|Replication")
+	bool bReplicateMotionIntensity = false;
+
+	// Smallest change of a normalized channel or motion intensity that is replicated
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Motion Intensity|Replication",
+		meta = (EditCondition = "bReplicateMotionIntensity", ClampMin = "0.0"))
+	float ReplicationThreshold = 0.01f;
+
+	// If true and the tracked component is a physics body, motion intensity is evaluated on the physics thread every
+	// physics step, from the body's velocities where it simulates. Must be set before BeginPlay.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Motion Intensity|Physics")
+	bool bEvaluateOnPhysicsThread = false;
+
+	// If true, motion is evaluated from the tracked component's velocity instead of its transform: physics velocity
+	// of simulating bodies, movement component velocity otherwise. Cheaper and one smoothing stage ahead.
+	// Angular motion needs a simulating body, other components report none. Must be set before BeginPlay.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Motion Intensity|Physics")
+	bool bUseComponentVelocity = false;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Config and coefficients, defaults are used if not set
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Motion Intensity")
+	TObjectPtr<UMotionIntensityPreset> Preset;
+
+	// Scene component whose transform is tracked, the owner's root component is used if not set
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Motion Intensity")
+	TObjectPtr<USceneComponent> TrackedComponent;
+
+private:
+	friend class UMotionIntensitySubsystem;
+
+	void RegisterWithSubsystem();
+	void UnregisterFromSubsystem();
+
+	// Outputs the latest motion intensity to the counter track, called by the subsystem
+	void TraceMotionIntensity();
+
+	// Quantizes the latest update into the replicated state on the server, called by the subsystem
+	void UpdateReplicatedMotionIntensity();
+
+	// Advances thresholds by the latest update, returns true if any of them changed state. Called by the subsystem.
+	bool UpdateThresholds(float DeltaTime);
+
+	// Fires events of the threshold changes since the last call, called by the subsystem once all components are updated
+	void BroadcastThresholdEvents();
+
+	UFUNCTION()
+	void OnRep_ReplicatedMotionIntensity();
+
+	// Server's motion intensity, only replicated if bReplicateMotionIntensity is set
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_ReplicatedMotionIntensity)
+	FMotionIntensityReplicatedData ReplicatedMotionIntensity;
+
+	// Location in the subsystem's batches, managed by the subsystem
+	int32 GroupIndex = INDEX_NONE;
+	int32 EntryIndex = INDEX_NONE;
+	int32 PhysicsEntryIndex = INDEX_NONE;
+
+	bool IsRegisteredWithSubsystem() const
+	{
+		return GroupIndex != INDEX_NONE || PhysicsEntryIndex != INDEX_NONE;
+	}
+
+	// Indices of thresholds that changed state and haven't fired their events yet
+	TArray<int32, TInlineAllocator<4>> PendingThresholdChanges;
+
+#if COUNTERSTRACE_ENABLED
+	// Created on first use, the counter keeps a pointer to its name
+	FString TraceCounterName;
+	TUniquePtr<FCountersTrace::FCounterFloat> TraceCounter;
+#endif
+};
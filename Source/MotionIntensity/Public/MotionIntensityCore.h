@@ -0,0 +1,2181 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+// Engine-independent motion intensity math, header-only and depending on the standard library only.
+// Everything is templated on the vector, quaternion, config, coefficients and motion data types, so the engine uses it
+// with its own types through MotionIntensityCoreAdapters.h, while benchmarks and tools use the plain types below.
+// Nothing in here validates its inputs: Delta Time must be > 0.0f and config and coefficients must be valid.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MOTIONINTENSITY_CORE_SSE 1
+#include <emmintrin.h>
+#else
+#define MOTIONINTENSITY_CORE_SSE 0
+#endif
+
+namespace MotionIntensityCore
+{
+	constexpr float Pi = 3.1415926535897932f;
+	constexpr float Sqrt2 = 1.4142135623730950488f;
+	constexpr float SmallNumber = 1.e-8f;
+	constexpr float KindaSmallNumber = 1.e-4f;
+
+	/* Plain types, mirroring the engine structs field by field */
+
+	// Smoothing of velocity and acceleration before they are differentiated, values match EMotionIntensityFilter
+	enum class EFilter : uint8_t
+	{
+		Exponential,
+		OneEuro,
+		CriticallyDampedSpring,
+		Biquad
+	};
+
+	// Memory of a filter beyond its previous output, what the fields hold depends on the filter
+	struct FFilterState
+	{
+		float Z1 = 0.0f;
+		float Z2 = 0.0f;
+		float Z3 = 0.0f;
+	};
+
+	struct FVector3
+	{
+		double X = 0.0;
+		double Y = 0.0;
+		double Z = 0.0;
+	};
+
+	struct FQuat4
+	{
+		double X = 0.0;
+		double Y = 0.0;
+		double Z = 0.0;
+		double W = 1.0;
+	};
+
+	struct FConfig
+	{
+		bool bCalculateLinearMotion = true;
+		float MaxLinearVelocity = 1000.0f;
+		bool bClampLinearVelocity = false;
+		float LocationInterpolationSpeed = 10.0f;
+		float LinearVelocityInterpolationSpeed = 10.0f;
+		float LinearAccelerationInterpolationSpeed = 10.0f;
+		bool bCalculateAngularMotion = true;
+		float MaxAngularVelocity = 4.0f;
+		bool bClampAngularVelocity = false;
+		float RotationInterpolationSpeed = 10.0f;
+		float AngularVelocityInterpolationSpeed = 10.0f;
+		float AngularAccelerationInterpolationSpeed = 10.0f;
+		EFilter Filter = EFilter::Exponential;
+		float OneEuroBeta = 0.5f;
+		float OneEuroDerivativeCutoff = 1.0f;
+		bool bUseFixedTimeStep = false;
+		float FixedTimeStep = 1.0f / 120.0f;
+		int MaxSubsteps = 8;
+	};
+
+	struct FCoefficients
+	{
+		float MotionIntensityMultiplier = 1.0f;
+		float LinearVelocityCoefficient = 0.0f;
+		float PositiveLinearAccelerationCoefficient = 1.0f;
+		float NegativeLinearAccelerationCoefficient = 1.0f;
+		float PositiveLinearJerkCoefficient = 1.0f;
+		float NegativeLinearJerkCoefficient = 1.0f;
+		float AngularVelocityCoefficient = 0.0f;
+		float PositiveAngularAccelerationCoefficient = 1.0f;
+		float NegativeAngularAccelerationCoefficient = 1.0f;
+		float PositiveAngularJerkCoefficient = 1.0f;
+		float NegativeAngularJerkCoefficient = 1.0f;
+	};
+
+	struct FMotionData
+	{
+		float LinearVelocityNormalized = 0.0f;
+		float PositiveLinearAccelerationNormalized = 0.0f;
+		float NegativeLinearAccelerationNormalized = 0.0f;
+		float PositiveLinearJerkNormalized = 0.0f;
+		float NegativeLinearJerkNormalized = 0.0f;
+		float AngularVelocityNormalized = 0.0f;
+		float PositiveAngularAccelerationNormalized = 0.0f;
+		float NegativeAngularAccelerationNormalized = 0.0f;
+		float PositiveAngularJerkNormalized = 0.0f;
+		float NegativeAngularJerkNormalized = 0.0f;
+	};
+
+	// Motion data with signed acceleration and jerk, the positive and negative channels are these split by sign
+	struct FPackedMotionData
+	{
+		float LinearVelocityNormalized = 0.0f;
+		float LinearAccelerationNormalized = 0.0f;
+		float LinearJerkNormalized = 0.0f;
+		float AngularVelocityNormalized = 0.0f;
+		float AngularAccelerationNormalized = 0.0f;
+		float AngularJerkNormalized = 0.0f;
+	};
+
+	// Single precision location, batches store them relative to their origin
+	struct FFloatVector3
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		float Z = 0.0f;
+	};
+
+	// Single precision rotation, aligned so it never straddles a cache line
+	struct alignas(16) FFloatQuat4
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		float Z = 0.0f;
+		float W = 1.0f;
+	};
+
+	struct FServiceData
+	{
+		bool bSetPreviousTransformToCurrent = true;
+		FVector3 PreviousLocation;
+		FQuat4 PreviousRotation;
+		float PreviousLinearVelocity = 0.0f;
+		float PreviousLinearAcceleration = 0.0f;
+		float PreviousLinearJerk = 0.0f;
+		float PreviousAngularVelocity = 0.0f;
+		float PreviousAngularAcceleration = 0.0f;
+		float PreviousAngularJerk = 0.0f;
+		FFilterState LinearVelocityFilterState;
+		FFilterState LinearAccelerationFilterState;
+		FFilterState AngularVelocityFilterState;
+		FFilterState AngularAccelerationFilterState;
+		float TimeAccumulator = 0.0f;
+		FMotionData FixedStepMotionData;
+	};
+
+	/* Adapters, specialize them to plug in other vector and quaternion types */
+
+	// Must provide:
+	// static VectorType InterpTo(const VectorType& Current, const VectorType& Target, float DeltaTime, float InterpSpeed)
+	// static double Distance(const VectorType& A, const VectorType& B)
+	// static void Difference(const VectorType& A, const VectorType& B, float& OutX, float& OutY, float& OutZ)
+	// static double Size(const VectorType& Vector)
+	template <typename VectorType>
+	struct TVectorAdapter;
+
+	// Must provide:
+	// static QuatType InterpTo(const QuatType& Current, const QuatType& Target, float DeltaTime, float InterpSpeed)
+	// static double AngularDistance(const QuatType& A, const QuatType& B)
+	// static void ToFloats(const QuatType& Quat, float& OutX, float& OutY, float& OutZ, float& OutW)
+	// static QuatType FromFloats(float X, float Y, float Z, float W)
+	template <typename QuatType>
+	struct TQuatAdapter;
+
+	template <typename ValueType>
+	inline ValueType Clamp(const ValueType Value, const ValueType Min, const ValueType Max)
+	{
+		return Value < Min ? Min : (Value < Max ? Value : Max);
+	}
+
+	// Same math as FMath for the plain types. Runs in double and rounds the results into the fields, so single
+	// precision types only lose precision where they're stored.
+	template <typename VectorType>
+	struct TPlainVectorAdapter
+	{
+		using ScalarType = decltype(VectorType::X);
+
+		// Same as FMath::VInterpTo
+		static VectorType InterpTo(const VectorType& Current, const VectorType& Target, const float DeltaTime, const float InterpSpeed)
+		{
+			if (InterpSpeed <= 0.0f)
+			{
+				return Target;
+			}
+
+			const double DistanceX = static_cast<double>(Target.X) - Current.X;
+			const double DistanceY = static_cast<double>(Target.Y) - Current.Y;
+			const double DistanceZ = static_cast<double>(Target.Z) - Current.Z;
+			if (DistanceX * DistanceX + DistanceY * DistanceY + DistanceZ * DistanceZ < KindaSmallNumber)
+			{
+				return Target;
+			}
+
+			const double Alpha = Clamp(DeltaTime * InterpSpeed, 0.0f, 1.0f);
+			return {
+				static_cast<ScalarType>(Current.X + DistanceX * Alpha),
+				static_cast<ScalarType>(Current.Y + DistanceY * Alpha),
+				static_cast<ScalarType>(Current.Z + DistanceZ * Alpha)
+			};
+		}
+
+		// Same as FMath::Lerp
+		static VectorType Lerp(const VectorType& A, const VectorType& B, const double Alpha)
+		{
+			return {
+				static_cast<ScalarType>(A.X + (static_cast<double>(B.X) - A.X) * Alpha),
+				static_cast<ScalarType>(A.Y + (static_cast<double>(B.Y) - A.Y) * Alpha),
+				static_cast<ScalarType>(A.Z + (static_cast<double>(B.Z) - A.Z) * Alpha)
+			};
+		}
+
+		static double Distance(const VectorType& A, const VectorType& B)
+		{
+			const double X = static_cast<double>(A.X) - B.X;
+			const double Y = static_cast<double>(A.Y) - B.Y;
+			const double Z = static_cast<double>(A.Z) - B.Z;
+			return std::sqrt(X * X + Y * Y + Z * Z);
+		}
+
+		static void Difference(const VectorType& A, const VectorType& B, float& OutX, float& OutY, float& OutZ)
+		{
+			OutX = static_cast<float>(static_cast<double>(A.X) - B.X);
+			OutY = static_cast<float>(static_cast<double>(A.Y) - B.Y);
+			OutZ = static_cast<float>(static_cast<double>(A.Z) - B.Z);
+		}
+
+		static double Size(const VectorType& Vector)
+		{
+			const double X = Vector.X;
+			const double Y = Vector.Y;
+			const double Z = Vector.Z;
+			return std::sqrt(X * X + Y * Y + Z * Z);
+		}
+	};
+
+	template <typename QuatType>
+	struct TPlainQuatAdapter
+	{
+		using ScalarType = decltype(QuatType::X);
+
+		// Same as FMath::QInterpTo
+		static QuatType InterpTo(const QuatType& Current, const QuatType& Target, const float DeltaTime, const float InterpSpeed)
+		{
+			if (InterpSpeed <= 0.0f || Equals(Current, Target))
+			{
+				return Target;
+			}
+
+			return Slerp(Current, Target, Clamp(InterpSpeed * DeltaTime, 0.0f, 1.0f));
+		}
+
+		// Same as FQuat::AngularDistance, but from the chord between the quaternions like the SIMD kernel, since acos of
+		// their dot product can't resolve the small angles between single precision rotations
+		static double AngularDistance(const QuatType& A, const QuatType& B)
+		{
+			const double InnerProduct = static_cast<double>(A.X) * B.X + static_cast<double>(A.Y) * B.Y
+				+ static_cast<double>(A.Z) * B.Z + static_cast<double>(A.W) * B.W;
+			const double Sign = InnerProduct >= 0.0 ? 1.0 : -1.0;
+			const double X = A.X - Sign * B.X;
+			const double Y = A.Y - Sign * B.Y;
+			const double Z = A.Z - Sign * B.Z;
+			const double W = A.W - Sign * B.W;
+			const double HalfChord = 0.5 * std::sqrt(X * X + Y * Y + Z * Z + W * W);
+			return 4.0 * std::asin(std::min(HalfChord, 1.0));
+		}
+
+		static void ToFloats(const QuatType& Quat, float& OutX, float& OutY, float& OutZ, float& OutW)
+		{
+			OutX = static_cast<float>(Quat.X);
+			OutY = static_cast<float>(Quat.Y);
+			OutZ = static_cast<float>(Quat.Z);
+			OutW = static_cast<float>(Quat.W);
+		}
+
+		static QuatType FromFloats(const float X, const float Y, const float Z, const float W)
+		{
+			return {X, Y, Z, W};
+		}
+
+		// Same as FQuat::Slerp
+		static QuatType Slerp(const QuatType& A, const QuatType& B, const double Alpha)
+		{
+			const double RawCosom = static_cast<double>(A.X) * B.X + static_cast<double>(A.Y) * B.Y
+				+ static_cast<double>(A.Z) * B.Z + static_cast<double>(A.W) * B.W;
+			const double Cosom = RawCosom >= 0.0 ? RawCosom : -RawCosom;
+
+			double Scale0;
+			double Scale1;
+			if (Cosom < 0.9999f)
+			{
+				const double Omega = std::acos(Cosom);
+				const double InverseSin = 1.0 / std::sin(Omega);
+				Scale0 = std::sin((1.0 - Alpha) * Omega) * InverseSin;
+				Scale1 = std::sin(Alpha * Omega) * InverseSin;
+			}
+			else
+			{
+				Scale0 = 1.0 - Alpha;
+				Scale1 = Alpha;
+			}
+			Scale1 = RawCosom >= 0.0 ? Scale1 : -Scale1;
+
+			const double X = Scale0 * A.X + Scale1 * B.X;
+			const double Y = Scale0 * A.Y + Scale1 * B.Y;
+			const double Z = Scale0 * A.Z + Scale1 * B.Z;
+			const double W = Scale0 * A.W + Scale1 * B.W;
+			const double SquareSum = X * X + Y * Y + Z * Z + W * W;
+			if (SquareSum < SmallNumber)
+			{
+				return QuatType();
+			}
+
+			const double Scale = 1.0 / std::sqrt(SquareSum);
+			return {
+				static_cast<ScalarType>(X * Scale),
+				static_cast<ScalarType>(Y * Scale),
+				static_cast<ScalarType>(Z * Scale),
+				static_cast<ScalarType>(W * Scale)
+			};
+		}
+
+	private:
+		// Same as FQuat::Equals with the default tolerance
+		static bool Equals(const QuatType& A, const QuatType& B)
+		{
+			return (std::abs(A.X - B.X) <= KindaSmallNumber && std::abs(A.Y - B.Y) <= KindaSmallNumber
+					&& std::abs(A.Z - B.Z) <= KindaSmallNumber && std::abs(A.W - B.W) <= KindaSmallNumber)
+				|| (std::abs(A.X + B.X) <= KindaSmallNumber && std::abs(A.Y + B.Y) <= KindaSmallNumber
+					&& std::abs(A.Z + B.Z) <= KindaSmallNumber && std::abs(A.W + B.W) <= KindaSmallNumber);
+		}
+	};
+
+	template <>
+	struct TVectorAdapter<FVector3> : TPlainVectorAdapter<FVector3>
+	{
+	};
+
+	template <>
+	struct TVectorAdapter<FFloatVector3> : TPlainVectorAdapter<FFloatVector3>
+	{
+	};
+
+	template <>
+	struct TQuatAdapter<FQuat4> : TPlainQuatAdapter<FQuat4>
+	{
+	};
+
+	template <>
+	struct TQuatAdapter<FFloatQuat4> : TPlainQuatAdapter<FFloatQuat4>
+	{
+	};
+
+	/* Packed motion data */
+
+	// Writes signed acceleration and jerk into motion data, split by sign into its positive and negative channels
+	template <typename MotionDataType>
+	void SetLinearDerivatives(MotionDataType& OutMotionData, const float Acceleration, const float Jerk)
+	{
+		OutMotionData.PositiveLinearAccelerationNormalized = std::max(0.0f, Acceleration);
+		OutMotionData.NegativeLinearAccelerationNormalized = std::abs(std::min(0.0f, Acceleration));
+		OutMotionData.PositiveLinearJerkNormalized = std::max(0.0f, Jerk);
+		OutMotionData.NegativeLinearJerkNormalized = std::abs(std::min(0.0f, Jerk));
+	}
+
+	template <typename MotionDataType>
+	void SetAngularDerivatives(MotionDataType& OutMotionData, const float Acceleration, const float Jerk)
+	{
+		OutMotionData.PositiveAngularAccelerationNormalized = std::max(0.0f, Acceleration);
+		OutMotionData.NegativeAngularAccelerationNormalized = std::abs(std::min(0.0f, Acceleration));
+		OutMotionData.PositiveAngularJerkNormalized = std::max(0.0f, Jerk);
+		OutMotionData.NegativeAngularJerkNormalized = std::abs(std::min(0.0f, Jerk));
+	}
+
+	// Packed motion data keeps the sign instead
+	inline void SetLinearDerivatives(FPackedMotionData& OutMotionData, const float Acceleration, const float Jerk)
+	{
+		OutMotionData.LinearAccelerationNormalized = Acceleration;
+		OutMotionData.LinearJerkNormalized = Jerk;
+	}
+
+	inline void SetAngularDerivatives(FPackedMotionData& OutMotionData, const float Acceleration, const float Jerk)
+	{
+		OutMotionData.AngularAccelerationNormalized = Acceleration;
+		OutMotionData.AngularJerkNormalized = Jerk;
+	}
+
+	template <typename MotionDataType>
+	FPackedMotionData PackMotionData(const MotionDataType& MotionData)
+	{
+		FPackedMotionData PackedMotionData;
+		PackedMotionData.LinearVelocityNormalized = MotionData.LinearVelocityNormalized;
+		PackedMotionData.LinearAccelerationNormalized = MotionData.PositiveLinearAccelerationNormalized - MotionData.NegativeLinearAccelerationNormalized;
+		PackedMotionData.LinearJerkNormalized = MotionData.PositiveLinearJerkNormalized - MotionData.NegativeLinearJerkNormalized;
+		PackedMotionData.AngularVelocityNormalized = MotionData.AngularVelocityNormalized;
+		PackedMotionData.AngularAccelerationNormalized = MotionData.PositiveAngularAccelerationNormalized - MotionData.NegativeAngularAccelerationNormalized;
+		PackedMotionData.AngularJerkNormalized = MotionData.PositiveAngularJerkNormalized - MotionData.NegativeAngularJerkNormalized;
+		return PackedMotionData;
+	}
+
+	template <typename MotionDataType>
+	MotionDataType UnpackMotionData(const FPackedMotionData& PackedMotionData)
+	{
+		MotionDataType MotionData{};
+		MotionData.LinearVelocityNormalized = PackedMotionData.LinearVelocityNormalized;
+		MotionData.AngularVelocityNormalized = PackedMotionData.AngularVelocityNormalized;
+		SetLinearDerivatives(MotionData, PackedMotionData.LinearAccelerationNormalized, PackedMotionData.LinearJerkNormalized);
+		SetAngularDerivatives(MotionData, PackedMotionData.AngularAccelerationNormalized, PackedMotionData.AngularJerkNormalized);
+		return MotionData;
+	}
+
+	/* Per-object kernels */
+
+	// Same as FMath::FInterpTo
+	inline float InterpTo(const float Current, const float Target, const float DeltaTime, const float InterpSpeed)
+	{
+		if (InterpSpeed <= 0.0f)
+		{
+			return Target;
+		}
+
+		const float Distance = Target - Current;
+		if (Distance * Distance < SmallNumber)
+		{
+			return Target;
+		}
+
+		return Current + Distance * Clamp(DeltaTime * InterpSpeed, 0.0f, 1.0f);
+	}
+
+	inline float GetSmoothedDerivative(const float Current,
+	                                   float& OutPrevious,
+	                                   const float DeltaTime,
+	                                   const float InterpolationSpeed)
+	{
+		const float SmoothedValue = InterpTo(OutPrevious, Current, DeltaTime, InterpolationSpeed);
+		const float Derivative = (SmoothedValue - OutPrevious) / DeltaTime;
+		OutPrevious = SmoothedValue;
+		return Derivative;
+	}
+
+	/* Derivative filters */
+
+	// Each filter smooths a value and returns its derivative through the same static function, so the kernels take the
+	// filter as a template parameter and DispatchFilter picks it once per call instead of branching per object.
+	// Previous is the last smoothed value for every filter, State holds whatever else a filter has to remember.
+	// Speed is the interpolation speed from the config, read as a cutoff in rad/s by the filters that have one.
+	// Settle puts a filter at rest at a value, as if it had been fed that value for a long time.
+	// Filters without bHasState never touch State, so batches don't have to store it for them.
+
+	// FInterpTo followed by differentiation, the original smoothing and the only one with SIMD kernels
+	struct FExponentialFilter
+	{
+		static constexpr bool bHasSimdKernel = true;
+		static constexpr bool bHasState = false;
+
+		template <typename FilterStateType, typename ConfigType>
+		static float GetSmoothedDerivative(const float Current,
+		                                   float& InOutPrevious,
+		                                   FilterStateType&,
+		                                   const float DeltaTime,
+		                                   const float Speed,
+		                                   const ConfigType&)
+		{
+			return MotionIntensityCore::GetSmoothedDerivative(Current, InOutPrevious, DeltaTime, Speed);
+		}
+
+		template <typename FilterStateType>
+		static void Settle(const float Value, float& OutPrevious, FilterStateType&)
+		{
+			OutPrevious = Value;
+		}
+	};
+
+	// Low-pass whose cutoff rises with the rate of change of the value, smooth at rest and with little lag in fast motion.
+	// Speed is the minimum cutoff. State: Z1 is the previous raw value, Z2 its smoothed derivative.
+	struct FOneEuroFilter
+	{
+		static constexpr bool bHasSimdKernel = false;
+		static constexpr bool bHasState = true;
+
+		template <typename FilterStateType, typename ConfigType>
+		static float GetSmoothedDerivative(const float Current,
+		                                   float& InOutPrevious,
+		                                   FilterStateType& InOutState,
+		                                   const float DeltaTime,
+		                                   const float Speed,
+		                                   const ConfigType& Config)
+		{
+			const float RawDerivative = (Current - InOutState.Z1) / DeltaTime;
+			InOutState.Z1 = Current;
+			InOutState.Z2 += (RawDerivative - InOutState.Z2) * GetAlpha(2.0f * Pi * Config.OneEuroDerivativeCutoff, DeltaTime);
+
+			const float CutoffSpeed = Speed + 2.0f * Pi * Config.OneEuroBeta * std::abs(InOutState.Z2);
+			const float SmoothedValue = InOutPrevious + (Current - InOutPrevious) * GetAlpha(CutoffSpeed, DeltaTime);
+			const float Derivative = (SmoothedValue - InOutPrevious) / DeltaTime;
+			InOutPrevious = SmoothedValue;
+			return Derivative;
+		}
+
+		template <typename FilterStateType>
+		static void Settle(const float Value, float& OutPrevious, FilterStateType& OutState)
+		{
+			OutPrevious = Value;
+			OutState.Z1 = Value;
+			OutState.Z2 = 0.0f;
+		}
+
+	private:
+		// Smoothing factor of a first order low-pass with the given cutoff in rad/s
+		static float GetAlpha(const float CutoffSpeed, const float DeltaTime)
+		{
+			const float Product = CutoffSpeed * DeltaTime;
+			return Product / (1.0f + Product);
+		}
+	};
+
+	// Critically damped spring chasing the value, integrated exactly so it's stable at any Delta Time. The derivative is
+	// the spring's own velocity instead of a difference of outputs. Speed is the natural frequency.
+	// State: Z1 is the spring velocity.
+	struct FCriticallyDampedSpringFilter
+	{
+		static constexpr bool bHasSimdKernel = false;
+		static constexpr bool bHasState = true;
+
+		template <typename FilterStateType, typename ConfigType>
+		static float GetSmoothedDerivative(const float Current,
+		                                   float& InOutPrevious,
+		                                   FilterStateType& InOutState,
+		                                   const float DeltaTime,
+		                                   const float Speed,
+		                                   const ConfigType&)
+		{
+			const float Decay = std::exp(-Speed * DeltaTime);
+			const float Offset = InOutPrevious - Current;
+			const float Impulse = (InOutState.Z1 + Speed * Offset) * DeltaTime;
+			InOutPrevious = Current + (Offset + Impulse) * Decay;
+			InOutState.Z1 = (InOutState.Z1 - Speed * Impulse) * Decay;
+			return InOutState.Z1;
+		}
+
+		template <typename FilterStateType>
+		static void Settle(const float Value, float& OutPrevious, FilterStateType& OutState)
+		{
+			OutPrevious = Value;
+			OutState.Z1 = 0.0f;
+		}
+	};
+
+	// Second order Butterworth low-pass from the bilinear transform, rolls noise off twice as steeply as the exponential
+	// filter. Speed is the cutoff, prewarped for the Delta Time of every step.
+	// State: Z1 and Z2 are the previous two inputs, Z3 is the output before the previous one.
+	struct FBiquadFilter
+	{
+		static constexpr bool bHasSimdKernel = false;
+		static constexpr bool bHasState = true;
+
+		template <typename FilterStateType, typename ConfigType>
+		static float GetSmoothedDerivative(const float Current,
+		                                   float& InOutPrevious,
+		                                   FilterStateType& InOutState,
+		                                   const float DeltaTime,
+		                                   const float Speed,
+		                                   const ConfigType&)
+		{
+			// Kept below the Nyquist frequency, where the prewarped cutoff goes to infinity
+			const float K = std::tan(std::min(0.5f * Speed * DeltaTime, 1.5f));
+			const float KSquared = K * K;
+			const float Normalization = 1.0f / (1.0f + Sqrt2 * K + KSquared);
+			const float B0 = KSquared * Normalization;
+			const float A1 = 2.0f * (KSquared - 1.0f) * Normalization;
+			const float A2 = (1.0f - Sqrt2 * K + KSquared) * Normalization;
+
+			const float SmoothedValue = B0 * (Current + 2.0f * InOutState.Z1 + InOutState.Z2) - A1 * InOutPrevious - A2 * InOutState.Z3;
+			InOutState.Z2 = InOutState.Z1;
+			InOutState.Z1 = Current;
+			InOutState.Z3 = InOutPrevious;
+
+			const float Derivative = (SmoothedValue - InOutPrevious) / DeltaTime;
+			InOutPrevious = SmoothedValue;
+			return Derivative;
+		}
+
+		template <typename FilterStateType>
+		static void Settle(const float Value, float& OutPrevious, FilterStateType& OutState)
+		{
+			OutPrevious = Value;
+			OutState.Z1 = Value;
+			OutState.Z2 = Value;
+			OutState.Z3 = Value;
+		}
+	};
+
+	// Calls Function with an instance of the filter chosen in the config
+	template <typename ConfigType, typename FunctionType>
+	decltype(auto) DispatchFilter(const ConfigType& Config, FunctionType&& Function)
+	{
+		switch (static_cast<EFilter>(Config.Filter))
+		{
+		case EFilter::OneEuro:
+			return Function(FOneEuroFilter());
+		case EFilter::CriticallyDampedSpring:
+			return Function(FCriticallyDampedSpringFilter());
+		case EFilter::Biquad:
+			return Function(FBiquadFilter());
+		default:
+			return Function(FExponentialFilter());
+		}
+	}
+
+	// Puts the derivative filters of Service Data at rest at the given smoothed velocities and accelerations, e.g. when
+	// they are overwritten from replicated motion data, so the next steps continue from them without a transient
+	template <typename ConfigType, typename ServiceDataType>
+	void SettleFilters(const float LinearVelocity,
+	                   const float LinearAcceleration,
+	                   const float AngularVelocity,
+	                   const float AngularAcceleration,
+	                   const ConfigType& Config,
+	                   ServiceDataType& ServiceData)
+	{
+		DispatchFilter(Config, [&](auto Filter)
+		{
+			using FilterType = decltype(Filter);
+			FilterType::Settle(LinearVelocity, ServiceData.PreviousLinearVelocity, ServiceData.LinearVelocityFilterState);
+			FilterType::Settle(LinearAcceleration, ServiceData.PreviousLinearAcceleration, ServiceData.LinearAccelerationFilterState);
+			FilterType::Settle(AngularVelocity, ServiceData.PreviousAngularVelocity, ServiceData.AngularVelocityFilterState);
+			FilterType::Settle(AngularAcceleration, ServiceData.PreviousAngularAcceleration, ServiceData.AngularAccelerationFilterState);
+		});
+	}
+
+	// The distance moved is taken from the interpolation alpha like the SIMD kernel does, instead of differencing the
+	// smoothed location, which would pick up its rounding when it's stored in single precision
+	template <typename VectorType>
+	float GetLinearVelocitySmoothed(const VectorType& Current,
+	                                VectorType& OutPrevious,
+	                                const float DeltaTime,
+	                                const float InterpolationSpeed)
+	{
+		using FAdapter = TVectorAdapter<VectorType>;
+
+		const double Distance = FAdapter::Distance(Current, OutPrevious);
+
+		// Same snapping as InterpTo, snapped locations move all the way to the target
+		const double Alpha = InterpolationSpeed <= 0.0f || Distance * Distance < KindaSmallNumber
+			                     ? 1.0
+			                     : Clamp(DeltaTime * InterpolationSpeed, 0.0f, 1.0f);
+
+		OutPrevious = FAdapter::InterpTo(OutPrevious, Current, DeltaTime, InterpolationSpeed);
+		return static_cast<float>(Distance * Alpha / DeltaTime);
+	}
+
+	template <typename QuatType>
+	float GetAngularVelocitySmoothed(const QuatType& Current,
+	                                 QuatType& OutPrevious,
+	                                 const float DeltaTime,
+	                                 const float InterpolationSpeed)
+	{
+		const QuatType SmoothedValue = TQuatAdapter<QuatType>::InterpTo(OutPrevious, Current, DeltaTime, InterpolationSpeed);
+		const float Revolutions = static_cast<float>(TQuatAdapter<QuatType>::AngularDistance(SmoothedValue, OutPrevious) / (2.0f * Pi)); // Convert radians to revolutions
+		OutPrevious = SmoothedValue;
+		return Revolutions / DeltaTime;
+	}
+
+	// Rest of the linear chain once the speed is known, speed is in cm/s
+	template <typename FilterType, typename ConfigType, typename FilterStateType, typename MotionDataType>
+	void CalculateLinearMotionDataFromVelocity(const float LinearSpeed,
+	                                           const float DeltaTime,
+	                                           const ConfigType& Config,
+	                                           float& PreviousLinearVelocity,
+	                                           float& PreviousLinearAcceleration,
+	                                           FilterStateType& LinearVelocityFilterState,
+	                                           FilterStateType& LinearAccelerationFilterState,
+	                                           MotionDataType& OutMotionData)
+	{
+		OutMotionData.LinearVelocityNormalized = LinearSpeed / Config.MaxLinearVelocity;
+
+		if (Config.bClampLinearVelocity)
+		{
+			OutMotionData.LinearVelocityNormalized = std::min(1.0f, OutMotionData.LinearVelocityNormalized);
+		}
+
+		const float LinearAccelerationNormalized = FilterType::GetSmoothedDerivative(OutMotionData.LinearVelocityNormalized,
+		                                                                             PreviousLinearVelocity,
+		                                                                             LinearVelocityFilterState,
+		                                                                             DeltaTime,
+		                                                                             Config.LinearVelocityInterpolationSpeed,
+		                                                                             Config) / Config.LinearVelocityInterpolationSpeed;
+		const float LinearJerkNormalized = FilterType::GetSmoothedDerivative(LinearAccelerationNormalized,
+		                                                                     PreviousLinearAcceleration,
+		                                                                     LinearAccelerationFilterState,
+		                                                                     DeltaTime,
+		                                                                     Config.LinearAccelerationInterpolationSpeed,
+		                                                                     Config) / Config.LinearAccelerationInterpolationSpeed;
+
+		SetLinearDerivatives(OutMotionData, LinearAccelerationNormalized, LinearJerkNormalized);
+	}
+
+	// Rest of the angular chain once the speed is known, speed is in rev/s
+	template <typename FilterType, typename ConfigType, typename FilterStateType, typename MotionDataType>
+	void CalculateAngularMotionDataFromVelocity(const float AngularSpeed,
+	                                            const float DeltaTime,
+	                                            const ConfigType& Config,
+	                                            float& PreviousAngularVelocity,
+	                                            float& PreviousAngularAcceleration,
+	                                            FilterStateType& AngularVelocityFilterState,
+	                                            FilterStateType& AngularAccelerationFilterState,
+	                                            MotionDataType& OutMotionData)
+	{
+		OutMotionData.AngularVelocityNormalized = AngularSpeed / Config.MaxAngularVelocity;
+
+		if (Config.bClampAngularVelocity)
+		{
+			OutMotionData.AngularVelocityNormalized = std::min(1.0f, OutMotionData.AngularVelocityNormalized);
+		}
+
+		const float AngularAccelerationNormalized = FilterType::GetSmoothedDerivative(OutMotionData.AngularVelocityNormalized,
+		                                                                              PreviousAngularVelocity,
+		                                                                              AngularVelocityFilterState,
+		                                                                              DeltaTime,
+		                                                                              Config.AngularVelocityInterpolationSpeed,
+		                                                                              Config) / Config.AngularVelocityInterpolationSpeed;
+		const float AngularJerkNormalized = FilterType::GetSmoothedDerivative(AngularAccelerationNormalized,
+		                                                                      PreviousAngularAcceleration,
+		                                                                      AngularAccelerationFilterState,
+		                                                                      DeltaTime,
+		                                                                      Config.AngularAccelerationInterpolationSpeed,
+		                                                                      Config) / Config.AngularAccelerationInterpolationSpeed;
+
+		SetAngularDerivatives(OutMotionData, AngularAccelerationNormalized, AngularJerkNormalized);
+	}
+
+	template <typename FilterType, typename VectorType, typename ConfigType, typename FilterStateType, typename MotionDataType>
+	void CalculateLinearMotionData(const VectorType& CurrentLocation,
+	                               const float DeltaTime,
+	                               const ConfigType& Config,
+	                               VectorType& PreviousLocation,
+	                               float& PreviousLinearVelocity,
+	                               float& PreviousLinearAcceleration,
+	                               FilterStateType& LinearVelocityFilterState,
+	                               FilterStateType& LinearAccelerationFilterState,
+	                               MotionDataType& OutMotionData)
+	{
+		const float LinearSpeed = GetLinearVelocitySmoothed(CurrentLocation,
+		                                                    PreviousLocation,
+		                                                    DeltaTime,
+		                                                    Config.LocationInterpolationSpeed);
+		CalculateLinearMotionDataFromVelocity<FilterType>(LinearSpeed,
+		                                                  DeltaTime,
+		                                                  Config,
+		                                                  PreviousLinearVelocity,
+		                                                  PreviousLinearAcceleration,
+		                                                  LinearVelocityFilterState,
+		                                                  LinearAccelerationFilterState,
+		                                                  OutMotionData);
+	}
+
+	template <typename FilterType, typename QuatType, typename ConfigType, typename FilterStateType, typename MotionDataType>
+	void CalculateAngularMotionData(const QuatType& CurrentRotation,
+	                                const float DeltaTime,
+	                                const ConfigType& Config,
+	                                QuatType& PreviousRotation,
+	                                float& PreviousAngularVelocity,
+	                                float& PreviousAngularAcceleration,
+	                                FilterStateType& AngularVelocityFilterState,
+	                                FilterStateType& AngularAccelerationFilterState,
+	                                MotionDataType& OutMotionData)
+	{
+		const float AngularSpeed = GetAngularVelocitySmoothed(CurrentRotation,
+		                                                      PreviousRotation,
+		                                                      DeltaTime,
+		                                                      Config.RotationInterpolationSpeed);
+		CalculateAngularMotionDataFromVelocity<FilterType>(AngularSpeed,
+		                                                   DeltaTime,
+		                                                   Config,
+		                                                   PreviousAngularVelocity,
+		                                                   PreviousAngularAcceleration,
+		                                                   AngularVelocityFilterState,
+		                                                   AngularAccelerationFilterState,
+		                                                   OutMotionData);
+	}
+
+	/* Fixed time step */
+
+	// Adds Delta Time to the accumulator and takes as many whole fixed steps out of it as are due.
+	// Time beyond MaxSubsteps isn't carried over, so a hitch doesn't turn into a burst of substeps on the next frames,
+	// instead the due steps are stretched to cover all of it and velocities stay true to the distance travelled.
+	inline int ConsumeFixedSteps(float& InOutTimeAccumulator,
+	                             const float DeltaTime,
+	                             const float FixedTimeStep,
+	                             const int MaxSubsteps,
+	                             float& OutStepTime)
+	{
+		InOutTimeAccumulator += DeltaTime;
+
+		const int Steps = static_cast<int>(InOutTimeAccumulator / FixedTimeStep);
+		if (Steps > MaxSubsteps)
+		{
+			OutStepTime = InOutTimeAccumulator / MaxSubsteps;
+			InOutTimeAccumulator = 0.0f;
+			return MaxSubsteps;
+		}
+
+		OutStepTime = FixedTimeStep;
+		InOutTimeAccumulator = std::max(0.0f, InOutTimeAccumulator - Steps * FixedTimeStep);
+		return Steps;
+	}
+
+	// Runs several steps that all chase the same target. Every step covers Alpha of the remaining distance, so the
+	// distances form a geometric series: only the scalar derivative chain is stepped, and the caller moves the previous
+	// transform once by the returned fraction instead of interpolating it Steps times.
+	template <typename FilterType, typename ConfigType, typename FilterStateType>
+	double StepTowardsTarget(const double Distance,
+	                         const double SnapDistance,
+	                         const int Steps,
+	                         const float StepTime,
+	                         const float InterpolationSpeed,
+	                         const float VelocityScale,
+	                         const bool bClampVelocity,
+	                         const float VelocityInterpolationSpeed,
+	                         const float AccelerationInterpolationSpeed,
+	                         const ConfigType& Config,
+	                         float& PreviousVelocity,
+	                         float& PreviousAcceleration,
+	                         FilterStateType& VelocityFilterState,
+	                         FilterStateType& AccelerationFilterState,
+	                         float& OutVelocity,
+	                         float& OutAcceleration,
+	                         float& OutJerk)
+	{
+		const double Alpha = Clamp(StepTime * InterpolationSpeed, 0.0f, 1.0f);
+		double Remaining = Distance;
+
+		for (int Step = 0; Step < Steps; ++Step)
+		{
+			const double Covered = Remaining < SnapDistance ? Remaining : Remaining * Alpha;
+			Remaining -= Covered;
+
+			OutVelocity = static_cast<float>(Covered / StepTime) * VelocityScale;
+			if (bClampVelocity)
+			{
+				OutVelocity = std::min(1.0f, OutVelocity);
+			}
+
+			OutAcceleration = FilterType::GetSmoothedDerivative(OutVelocity,
+			                                                    PreviousVelocity,
+			                                                    VelocityFilterState,
+			                                                    StepTime,
+			                                                    VelocityInterpolationSpeed,
+			                                                    Config) / VelocityInterpolationSpeed;
+			OutJerk = FilterType::GetSmoothedDerivative(OutAcceleration,
+			                                            PreviousAcceleration,
+			                                            AccelerationFilterState,
+			                                            StepTime,
+			                                            AccelerationInterpolationSpeed,
+			                                            Config) / AccelerationInterpolationSpeed;
+		}
+
+		return Distance > 0.0 ? 1.0 - Remaining / Distance : 1.0;
+	}
+
+	// Same as running CalculateLinearMotionData Steps times with the same location
+	template <typename FilterType, typename VectorType, typename ConfigType, typename FilterStateType, typename MotionDataType>
+	void CalculateLinearMotionDataSubstepped(const VectorType& CurrentLocation,
+	                                         const int Steps,
+	                                         const float StepTime,
+	                                         const ConfigType& Config,
+	                                         VectorType& PreviousLocation,
+	                                         float& PreviousLinearVelocity,
+	                                         float& PreviousLinearAcceleration,
+	                                         FilterStateType& LinearVelocityFilterState,
+	                                         FilterStateType& LinearAccelerationFilterState,
+	                                         MotionDataType& OutMotionData)
+	{
+		using FAdapter = TVectorAdapter<VectorType>;
+
+		float LinearAccelerationNormalized = 0.0f;
+		float LinearJerkNormalized = 0.0f;
+		const double Fraction = StepTowardsTarget<FilterType>(FAdapter::Distance(CurrentLocation, PreviousLocation),
+		                                                      std::sqrt(KindaSmallNumber), // Same threshold as InterpTo
+		                                                      Steps,
+		                                                      StepTime,
+		                                                      Config.LocationInterpolationSpeed,
+		                                                      1.0f / Config.MaxLinearVelocity,
+		                                                      Config.bClampLinearVelocity,
+		                                                      Config.LinearVelocityInterpolationSpeed,
+		                                                      Config.LinearAccelerationInterpolationSpeed,
+		                                                      Config,
+		                                                      PreviousLinearVelocity,
+		                                                      PreviousLinearAcceleration,
+		                                                      LinearVelocityFilterState,
+		                                                      LinearAccelerationFilterState,
+		                                                      OutMotionData.LinearVelocityNormalized,
+		                                                      LinearAccelerationNormalized,
+		                                                      LinearJerkNormalized);
+		PreviousLocation = FAdapter::InterpTo(PreviousLocation, CurrentLocation, static_cast<float>(Fraction), 1.0f);
+
+		SetLinearDerivatives(OutMotionData, LinearAccelerationNormalized, LinearJerkNormalized);
+	}
+
+	// Same as running CalculateAngularMotionData Steps times with the same rotation, slerp covers the same fraction
+	// of the angle as it does of the interpolation alpha, so the angles form the same geometric series
+	template <typename FilterType, typename QuatType, typename ConfigType, typename FilterStateType, typename MotionDataType>
+	void CalculateAngularMotionDataSubstepped(const QuatType& CurrentRotation,
+	                                          const int Steps,
+	                                          const float StepTime,
+	                                          const ConfigType& Config,
+	                                          QuatType& PreviousRotation,
+	                                          float& PreviousAngularVelocity,
+	                                          float& PreviousAngularAcceleration,
+	                                          FilterStateType& AngularVelocityFilterState,
+	                                          FilterStateType& AngularAccelerationFilterState,
+	                                          MotionDataType& OutMotionData)
+	{
+		using FAdapter = TQuatAdapter<QuatType>;
+
+		float AngularAccelerationNormalized = 0.0f;
+		float AngularJerkNormalized = 0.0f;
+		const double Fraction = StepTowardsTarget<FilterType>(FAdapter::AngularDistance(CurrentRotation, PreviousRotation),
+		                                                      2.0f * KindaSmallNumber, // Roughly where InterpTo considers rotations equal
+		                                                      Steps,
+		                                                      StepTime,
+		                                                      Config.RotationInterpolationSpeed,
+		                                                      1.0f / (2.0f * Pi * Config.MaxAngularVelocity), // Radians to normalized revolutions
+		                                                      Config.bClampAngularVelocity,
+		                                                      Config.AngularVelocityInterpolationSpeed,
+		                                                      Config.AngularAccelerationInterpolationSpeed,
+		                                                      Config,
+		                                                      PreviousAngularVelocity,
+		                                                      PreviousAngularAcceleration,
+		                                                      AngularVelocityFilterState,
+		                                                      AngularAccelerationFilterState,
+		                                                      OutMotionData.AngularVelocityNormalized,
+		                                                      AngularAccelerationNormalized,
+		                                                      AngularJerkNormalized);
+		PreviousRotation = FAdapter::InterpTo(PreviousRotation, CurrentRotation, static_cast<float>(Fraction), 1.0f);
+
+		SetAngularDerivatives(OutMotionData, AngularAccelerationNormalized, AngularJerkNormalized);
+	}
+
+	// Advances one object by the given number of fixed steps. Zero steps leave the motion data untouched, one step is
+	// exactly the variable time step kernel, more steps use the collapsed form above.
+	template <typename FilterType, typename VectorType, typename QuatType, typename ConfigType, typename FilterStateType, typename MotionDataType>
+	void CalculateMotionDataSteps(const VectorType& Location,
+	                              const QuatType& Rotation,
+	                              const int Steps,
+	                              const float StepTime,
+	                              const ConfigType& Config,
+	                              VectorType& PreviousLocation,
+	                              QuatType& PreviousRotation,
+	                              float& PreviousLinearVelocity,
+	                              float& PreviousLinearAcceleration,
+	                              float& PreviousAngularVelocity,
+	                              float& PreviousAngularAcceleration,
+	                              FilterStateType& LinearVelocityFilterState,
+	                              FilterStateType& LinearAccelerationFilterState,
+	                              FilterStateType& AngularVelocityFilterState,
+	                              FilterStateType& AngularAccelerationFilterState,
+	                              MotionDataType& InOutMotionData)
+	{
+		if (Steps == 0)
+		{
+			return;
+		}
+
+		InOutMotionData = MotionDataType{};
+
+		if (Config.bCalculateLinearMotion)
+		{
+			if (Steps == 1)
+			{
+				CalculateLinearMotionData<FilterType>(Location,
+				                                      StepTime,
+				                                      Config,
+				                                      PreviousLocation,
+				                                      PreviousLinearVelocity,
+				                                      PreviousLinearAcceleration,
+				                                      LinearVelocityFilterState,
+				                                      LinearAccelerationFilterState,
+				                                      InOutMotionData);
+			}
+			else
+			{
+				CalculateLinearMotionDataSubstepped<FilterType>(Location,
+				                                                Steps,
+				                                                StepTime,
+				                                                Config,
+				                                                PreviousLocation,
+				                                                PreviousLinearVelocity,
+				                                                PreviousLinearAcceleration,
+				                                                LinearVelocityFilterState,
+				                                                LinearAccelerationFilterState,
+				                                                InOutMotionData);
+			}
+		}
+		if (Config.bCalculateAngularMotion)
+		{
+			if (Steps == 1)
+			{
+				CalculateAngularMotionData<FilterType>(Rotation,
+				                                       StepTime,
+				                                       Config,
+				                                       PreviousRotation,
+				                                       PreviousAngularVelocity,
+				                                       PreviousAngularAcceleration,
+				                                       AngularVelocityFilterState,
+				                                       AngularAccelerationFilterState,
+				                                       InOutMotionData);
+			}
+			else
+			{
+				CalculateAngularMotionDataSubstepped<FilterType>(Rotation,
+				                                                 Steps,
+				                                                 StepTime,
+				                                                 Config,
+				                                                 PreviousRotation,
+				                                                 PreviousAngularVelocity,
+				                                                 PreviousAngularAcceleration,
+				                                                 AngularVelocityFilterState,
+				                                                 AngularAccelerationFilterState,
+				                                                 InOutMotionData);
+			}
+		}
+	}
+
+	// Advances Service Data by Delta Time with the given filter, fixed steps or a single variable step
+	template <typename FilterType, typename MotionDataType, typename VectorType, typename QuatType, typename ConfigType, typename ServiceDataType>
+	MotionDataType CalculateMotionDataWithFilter(const VectorType& Location,
+	                                             const QuatType& Rotation,
+	                                             const float DeltaTime,
+	                                             const ConfigType& Config,
+	                                             ServiceDataType& ServiceData)
+	{
+		if (ServiceData.bSetPreviousTransformToCurrent)
+		{
+			ServiceData.PreviousLocation = Location;
+			ServiceData.PreviousRotation = Rotation;
+			ServiceData.bSetPreviousTransformToCurrent = false;
+		}
+
+		int Steps = 1;
+		float StepTime = DeltaTime;
+		if (Config.bUseFixedTimeStep)
+		{
+			Steps = ConsumeFixedSteps(ServiceData.TimeAccumulator, DeltaTime, Config.FixedTimeStep, Config.MaxSubsteps, StepTime);
+		}
+
+		MotionDataType MotionData{};
+		MotionDataType& OutMotionData = Config.bUseFixedTimeStep ? ServiceData.FixedStepMotionData : MotionData;
+		CalculateMotionDataSteps<FilterType>(Location,
+		                                     Rotation,
+		                                     Steps,
+		                                     StepTime,
+		                                     Config,
+		                                     ServiceData.PreviousLocation,
+		                                     ServiceData.PreviousRotation,
+		                                     ServiceData.PreviousLinearVelocity,
+		                                     ServiceData.PreviousLinearAcceleration,
+		                                     ServiceData.PreviousAngularVelocity,
+		                                     ServiceData.PreviousAngularAcceleration,
+		                                     ServiceData.LinearVelocityFilterState,
+		                                     ServiceData.LinearAccelerationFilterState,
+		                                     ServiceData.AngularVelocityFilterState,
+		                                     ServiceData.AngularAccelerationFilterState,
+		                                     OutMotionData);
+		return OutMotionData;
+	}
+
+	template <typename MotionDataType, typename VectorType, typename QuatType, typename ConfigType, typename ServiceDataType>
+	MotionDataType CalculateMotionData(const VectorType& Location,
+	                                   const QuatType& Rotation,
+	                                   const float DeltaTime,
+	                                   const ConfigType& Config,
+	                                   ServiceDataType& ServiceData)
+	{
+		return DispatchFilter(Config, [&](auto Filter)
+		{
+			return CalculateMotionDataWithFilter<decltype(Filter), MotionDataType>(Location, Rotation, DeltaTime, Config, ServiceData);
+		});
+	}
+
+	/* Velocity input */
+
+	// Same as CalculateMotionDataSteps for sources that know their velocity, e.g. physics bodies. Velocity is held over
+	// the steps and only the scalar chain is stepped. Linear speed is in cm/s, angular speed in rev/s.
+	template <typename FilterType, typename ConfigType, typename FilterStateType, typename MotionDataType>
+	void CalculateMotionDataFromVelocitySteps(const float LinearSpeed,
+	                                          const float AngularSpeed,
+	                                          const int Steps,
+	                                          const float StepTime,
+	                                          const ConfigType& Config,
+	                                          float& PreviousLinearVelocity,
+	                                          float& PreviousLinearAcceleration,
+	                                          float& PreviousAngularVelocity,
+	                                          float& PreviousAngularAcceleration,
+	                                          FilterStateType& LinearVelocityFilterState,
+	                                          FilterStateType& LinearAccelerationFilterState,
+	                                          FilterStateType& AngularVelocityFilterState,
+	                                          FilterStateType& AngularAccelerationFilterState,
+	                                          MotionDataType& InOutMotionData)
+	{
+		if (Steps == 0)
+		{
+			return;
+		}
+
+		InOutMotionData = MotionDataType{};
+
+		for (int Step = 0; Step < Steps; ++Step)
+		{
+			if (Config.bCalculateLinearMotion)
+			{
+				CalculateLinearMotionDataFromVelocity<FilterType>(LinearSpeed,
+				                                                  StepTime,
+				                                                  Config,
+				                                                  PreviousLinearVelocity,
+				                                                  PreviousLinearAcceleration,
+				                                                  LinearVelocityFilterState,
+				                                                  LinearAccelerationFilterState,
+				                                                  InOutMotionData);
+			}
+			if (Config.bCalculateAngularMotion)
+			{
+				CalculateAngularMotionDataFromVelocity<FilterType>(AngularSpeed,
+				                                                   StepTime,
+				                                                   Config,
+				                                                   PreviousAngularVelocity,
+				                                                   PreviousAngularAcceleration,
+				                                                   AngularVelocityFilterState,
+				                                                   AngularAccelerationFilterState,
+				                                                   InOutMotionData);
+			}
+		}
+	}
+
+	// Advances Service Data by Delta Time from velocities with the given filter, fixed steps or a single variable step
+	template <typename FilterType, typename MotionDataType, typename ConfigType, typename ServiceDataType>
+	MotionDataType CalculateMotionDataFromVelocityWithFilter(const float LinearSpeed,
+	                                                         const float AngularSpeed,
+	                                                         const float DeltaTime,
+	                                                         const ConfigType& Config,
+	                                                         ServiceDataType& ServiceData)
+	{
+		int Steps = 1;
+		float StepTime = DeltaTime;
+		if (Config.bUseFixedTimeStep)
+		{
+			Steps = ConsumeFixedSteps(ServiceData.TimeAccumulator, DeltaTime, Config.FixedTimeStep, Config.MaxSubsteps, StepTime);
+		}
+
+		MotionDataType MotionData{};
+		MotionDataType& OutMotionData = Config.bUseFixedTimeStep ? ServiceData.FixedStepMotionData : MotionData;
+		CalculateMotionDataFromVelocitySteps<FilterType>(LinearSpeed,
+		                                                 AngularSpeed,
+		                                                 Steps,
+		                                                 StepTime,
+		                                                 Config,
+		                                                 ServiceData.PreviousLinearVelocity,
+		                                                 ServiceData.PreviousLinearAcceleration,
+		                                                 ServiceData.PreviousAngularVelocity,
+		                                                 ServiceData.PreviousAngularAcceleration,
+		                                                 ServiceData.LinearVelocityFilterState,
+		                                                 ServiceData.LinearAccelerationFilterState,
+		                                                 ServiceData.AngularVelocityFilterState,
+		                                                 ServiceData.AngularAccelerationFilterState,
+		                                                 OutMotionData);
+		return OutMotionData;
+	}
+
+	// Same as CalculateMotionData for sources that know their velocity. Skips the interpolated transform and its
+	// differencing, so it's cheaper and one smoothing stage ahead. Previous transform is untouched.
+	// Linear speed is in cm/s, angular speed in rev/s.
+	template <typename MotionDataType, typename ConfigType, typename ServiceDataType>
+	MotionDataType CalculateMotionDataFromVelocity(const float LinearSpeed,
+	                                               const float AngularSpeed,
+	                                               const float DeltaTime,
+	                                               const ConfigType& Config,
+	                                               ServiceDataType& ServiceData)
+	{
+		return DispatchFilter(Config, [&](auto Filter)
+		{
+			return CalculateMotionDataFromVelocityWithFilter<decltype(Filter), MotionDataType>(LinearSpeed, AngularSpeed, DeltaTime, Config, ServiceData);
+		});
+	}
+
+	/* Intensity reducers */
+
+	template <typename MotionDataType, typename CoefficientsType>
+	float GetLinearMotionIntensityFromMotionData(const MotionDataType& MotionData, const CoefficientsType& Coefficients)
+	{
+		const float SumOfSquares = MotionData.LinearVelocityNormalized * Coefficients.LinearVelocityCoefficient * (MotionData.LinearVelocityNormalized * Coefficients.LinearVelocityCoefficient)
+			+ MotionData.PositiveLinearAccelerationNormalized * Coefficients.PositiveLinearAccelerationCoefficient * (MotionData.PositiveLinearAccelerationNormalized * Coefficients.PositiveLinearAccelerationCoefficient)
+			+ MotionData.NegativeLinearAccelerationNormalized * Coefficients.NegativeLinearAccelerationCoefficient * (MotionData.NegativeLinearAccelerationNormalized * Coefficients.NegativeLinearAccelerationCoefficient)
+			+ MotionData.PositiveLinearJerkNormalized * Coefficients.PositiveLinearJerkCoefficient * (MotionData.PositiveLinearJerkNormalized * Coefficients.PositiveLinearJerkCoefficient)
+			+ MotionData.NegativeLinearJerkNormalized * Coefficients.NegativeLinearJerkCoefficient * (MotionData.NegativeLinearJerkNormalized * Coefficients.NegativeLinearJerkCoefficient);
+
+		if (SumOfSquares == 0.0f)
+		{
+			return 0.0f;
+		}
+
+		const float LinearMotionIntensity = std::sqrt(SumOfSquares);
+
+		const float MaxPossibleLinearMotionIntensity = std::sqrt(
+			Coefficients.LinearVelocityCoefficient * Coefficients.LinearVelocityCoefficient
+			+ Coefficients.PositiveLinearAccelerationCoefficient * Coefficients.PositiveLinearAccelerationCoefficient
+			+ Coefficients.NegativeLinearAccelerationCoefficient * Coefficients.NegativeLinearAccelerationCoefficient
+			+ Coefficients.PositiveLinearJerkCoefficient * Coefficients.PositiveLinearJerkCoefficient
+			+ Coefficients.NegativeLinearJerkCoefficient * Coefficients.NegativeLinearJerkCoefficient
+		);
+
+		if (MaxPossibleLinearMotionIntensity == 0.0f)
+		{
+			return 0.0f;
+		}
+
+		return (LinearMotionIntensity / MaxPossibleLinearMotionIntensity) * Coefficients.MotionIntensityMultiplier;
+	}
+
+	template <typename MotionDataType, typename CoefficientsType>
+	float GetAngularMotionIntensityFromMotionData(const MotionDataType& MotionData, const CoefficientsType& Coefficients)
+	{
+		const float SumOfSquares = MotionData.AngularVelocityNormalized * Coefficients.AngularVelocityCoefficient * (MotionData.AngularVelocityNormalized * Coefficients.AngularVelocityCoefficient)
+			+ MotionData.PositiveAngularAccelerationNormalized * Coefficients.PositiveAngularAccelerationCoefficient * (MotionData.PositiveAngularAccelerationNormalized * Coefficients.PositiveAngularAccelerationCoefficient)
+			+ MotionData.NegativeAngularAccelerationNormalized * Coefficients.NegativeAngularAccelerationCoefficient * (MotionData.NegativeAngularAccelerationNormalized * Coefficients.NegativeAngularAccelerationCoefficient)
+			+ MotionData.PositiveAngularJerkNormalized * Coefficients.PositiveAngularJerkCoefficient * (MotionData.PositiveAngularJerkNormalized * Coefficients.PositiveAngularJerkCoefficient)
+			+ MotionData.NegativeAngularJerkNormalized * Coefficients.NegativeAngularJerkCoefficient * (MotionData.NegativeAngularJerkNormalized * Coefficients.NegativeAngularJerkCoefficient);
+
+		if (SumOfSquares == 0.0f)
+		{
+			return 0.0f;
+		}
+
+		const float AngularMotionIntensity = std::sqrt(SumOfSquares);
+
+		const float MaxPossibleAngularMotionIntensity = std::sqrt(
+			Coefficients.AngularVelocityCoefficient * Coefficients.AngularVelocityCoefficient
+			+ Coefficients.PositiveAngularAccelerationCoefficient * Coefficients.PositiveAngularAccelerationCoefficient
+			+ Coefficients.NegativeAngularAccelerationCoefficient * Coefficients.NegativeAngularAccelerationCoefficient
+			+ Coefficients.PositiveAngularJerkCoefficient * Coefficients.PositiveAngularJerkCoefficient
+			+ Coefficients.NegativeAngularJerkCoefficient * Coefficients.NegativeAngularJerkCoefficient
+		);
+
+		if (MaxPossibleAngularMotionIntensity == 0.0f)
+		{
+			return 0.0f;
+		}
+
+		return (AngularMotionIntensity / MaxPossibleAngularMotionIntensity) * Coefficients.MotionIntensityMultiplier;
+	}
+
+	template <typename MotionDataType, typename CoefficientsType>
+	float GetMotionIntensityFromMotionData(const MotionDataType& MotionData, const CoefficientsType& Coefficients)
+	{
+		const float LinearMotionIntensity = GetLinearMotionIntensityFromMotionData(MotionData, Coefficients);
+		const float AngularMotionIntensity = GetAngularMotionIntensityFromMotionData(MotionData, Coefficients);
+
+		return std::sqrt(
+			LinearMotionIntensity * LinearMotionIntensity +
+			AngularMotionIntensity * AngularMotionIntensity
+		) / Sqrt2;
+	}
+
+	/* Compiled coefficients */
+
+	// Coefficients resolved once into squared weights already divided by the squared maximum possible intensity of
+	// their group, so evaluating them is a dot product with the squared motion data and a single square root
+	struct FCompiledCoefficients
+	{
+		// Velocity, positive and negative acceleration, positive and negative jerk
+		static constexpr int NumChannels = 5;
+
+		float LinearWeights[NumChannels] = {};
+		float AngularWeights[NumChannels] = {};
+		float MotionIntensityMultiplier = 0.0f;
+		bool bIsValid = false;
+	};
+
+	template <typename CoefficientsType>
+	FCompiledCoefficients CompileCoefficients(const CoefficientsType& Coefficients)
+	{
+		const float Linear[FCompiledCoefficients::NumChannels] = {
+			Coefficients.LinearVelocityCoefficient,
+			Coefficients.PositiveLinearAccelerationCoefficient,
+			Coefficients.NegativeLinearAccelerationCoefficient,
+			Coefficients.PositiveLinearJerkCoefficient,
+			Coefficients.NegativeLinearJerkCoefficient
+		};
+		const float Angular[FCompiledCoefficients::NumChannels] = {
+			Coefficients.AngularVelocityCoefficient,
+			Coefficients.PositiveAngularAccelerationCoefficient,
+			Coefficients.NegativeAngularAccelerationCoefficient,
+			Coefficients.PositiveAngularJerkCoefficient,
+			Coefficients.NegativeAngularJerkCoefficient
+		};
+
+		FCompiledCoefficients Compiled;
+		Compiled.MotionIntensityMultiplier = Coefficients.MotionIntensityMultiplier;
+		Compiled.bIsValid = true;
+
+		float LinearSumOfSquares = 0.0f;
+		float AngularSumOfSquares = 0.0f;
+		for (int Channel = 0; Channel < FCompiledCoefficients::NumChannels; ++Channel)
+		{
+			Compiled.bIsValid = Compiled.bIsValid && Linear[Channel] >= 0.0f && Angular[Channel] >= 0.0f;
+			LinearSumOfSquares += Linear[Channel] * Linear[Channel];
+			AngularSumOfSquares += Angular[Channel] * Angular[Channel];
+		}
+
+		// A group without any weight never contributes, same as a zero maximum possible intensity
+		for (int Channel = 0; Channel < FCompiledCoefficients::NumChannels; ++Channel)
+		{
+			Compiled.LinearWeights[Channel] = LinearSumOfSquares > 0.0f ? Linear[Channel] * Linear[Channel] / LinearSumOfSquares : 0.0f;
+			Compiled.AngularWeights[Channel] = AngularSumOfSquares > 0.0f ? Angular[Channel] * Angular[Channel] / AngularSumOfSquares : 0.0f;
+		}
+
+		return Compiled;
+	}
+
+	template <typename MotionDataType>
+	float GetLinearSumOfSquares(const MotionDataType& MotionData, const FCompiledCoefficients& Coefficients)
+	{
+		return Coefficients.LinearWeights[0] * (MotionData.LinearVelocityNormalized * MotionData.LinearVelocityNormalized)
+			+ Coefficients.LinearWeights[1] * (MotionData.PositiveLinearAccelerationNormalized * MotionData.PositiveLinearAccelerationNormalized)
+			+ Coefficients.LinearWeights[2] * (MotionData.NegativeLinearAccelerationNormalized * MotionData.NegativeLinearAccelerationNormalized)
+			+ Coefficients.LinearWeights[3] * (MotionData.PositiveLinearJerkNormalized * MotionData.PositiveLinearJerkNormalized)
+			+ Coefficients.LinearWeights[4] * (MotionData.NegativeLinearJerkNormalized * MotionData.NegativeLinearJerkNormalized);
+	}
+
+	template <typename MotionDataType>
+	float GetAngularSumOfSquares(const MotionDataType& MotionData, const FCompiledCoefficients& Coefficients)
+	{
+		return Coefficients.AngularWeights[0] * (MotionData.AngularVelocityNormalized * MotionData.AngularVelocityNormalized)
+			+ Coefficients.AngularWeights[1] * (MotionData.PositiveAngularAccelerationNormalized * MotionData.PositiveAngularAccelerationNormalized)
+			+ Coefficients.AngularWeights[2] * (MotionData.NegativeAngularAccelerationNormalized * MotionData.NegativeAngularAccelerationNormalized)
+			+ Coefficients.AngularWeights[3] * (MotionData.PositiveAngularJerkNormalized * MotionData.PositiveAngularJerkNormalized)
+			+ Coefficients.AngularWeights[4] * (MotionData.NegativeAngularJerkNormalized * MotionData.NegativeAngularJerkNormalized);
+	}
+
+	// Only one of the positive and negative channels is ever non-zero, so packed motion data picks its weight by sign
+	inline float GetLinearSumOfSquares(const FPackedMotionData& MotionData, const FCompiledCoefficients& Coefficients)
+	{
+		const float Acceleration = MotionData.LinearAccelerationNormalized;
+		const float Jerk = MotionData.LinearJerkNormalized;
+		return Coefficients.LinearWeights[0] * (MotionData.LinearVelocityNormalized * MotionData.LinearVelocityNormalized)
+			+ Coefficients.LinearWeights[Acceleration >= 0.0f ? 1 : 2] * (Acceleration * Acceleration)
+			+ Coefficients.LinearWeights[Jerk >= 0.0f ? 3 : 4] * (Jerk * Jerk);
+	}
+
+	inline float GetAngularSumOfSquares(const FPackedMotionData& MotionData, const FCompiledCoefficients& Coefficients)
+	{
+		const float Acceleration = MotionData.AngularAccelerationNormalized;
+		const float Jerk = MotionData.AngularJerkNormalized;
+		return Coefficients.AngularWeights[0] * (MotionData.AngularVelocityNormalized * MotionData.AngularVelocityNormalized)
+			+ Coefficients.AngularWeights[Acceleration >= 0.0f ? 1 : 2] * (Acceleration * Acceleration)
+			+ Coefficients.AngularWeights[Jerk >= 0.0f ? 3 : 4] * (Jerk * Jerk);
+	}
+
+	template <typename MotionDataType>
+	float GetLinearMotionIntensityFromMotionData(const MotionDataType& MotionData, const FCompiledCoefficients& Coefficients)
+	{
+		return std::sqrt(GetLinearSumOfSquares(MotionData, Coefficients)) * Coefficients.MotionIntensityMultiplier;
+	}
+
+	template <typename MotionDataType>
+	float GetAngularMotionIntensityFromMotionData(const MotionDataType& MotionData, const FCompiledCoefficients& Coefficients)
+	{
+		return std::sqrt(GetAngularSumOfSquares(MotionData, Coefficients)) * Coefficients.MotionIntensityMultiplier;
+	}
+
+	template <typename MotionDataType>
+	float GetMotionIntensityFromMotionData(const MotionDataType& MotionData, const FCompiledCoefficients& Coefficients)
+	{
+		return std::sqrt(GetLinearSumOfSquares(MotionData, Coefficients) + GetAngularSumOfSquares(MotionData, Coefficients))
+			* (std::abs(Coefficients.MotionIntensityMultiplier) / Sqrt2);
+	}
+
+	/* Four-wide SIMD layer, SSE2 where available and plain arrays elsewhere */
+
+	namespace Simd
+	{
+		constexpr int Width = 4;
+
+#if MOTIONINTENSITY_CORE_SSE
+		using FFloat4 = __m128;
+		using FMask4 = __m128;
+
+		inline FFloat4 Load(const float* Source) { return _mm_loadu_ps(Source); }
+		inline void Store(const FFloat4 Value, float* Destination) { _mm_storeu_ps(Destination, Value); }
+		inline FFloat4 Set1(const float Value) { return _mm_set1_ps(Value); }
+		inline FFloat4 Add(const FFloat4 A, const FFloat4 B) { return _mm_add_ps(A, B); }
+		inline FFloat4 Subtract(const FFloat4 A, const FFloat4 B) { return _mm_sub_ps(A, B); }
+		inline FFloat4 Multiply(const FFloat4 A, const FFloat4 B) { return _mm_mul_ps(A, B); }
+		inline FFloat4 Divide(const FFloat4 A, const FFloat4 B) { return _mm_div_ps(A, B); }
+		inline FFloat4 Min(const FFloat4 A, const FFloat4 B) { return _mm_min_ps(A, B); }
+		inline FFloat4 Max(const FFloat4 A, const FFloat4 B) { return _mm_max_ps(A, B); }
+		inline FFloat4 Sqrt(const FFloat4 Value) { return _mm_sqrt_ps(Value); }
+		inline FFloat4 Abs(const FFloat4 Value) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), Value); }
+		inline FFloat4 Negate(const FFloat4 Value) { return _mm_xor_ps(_mm_set1_ps(-0.0f), Value); }
+		inline FMask4 CompareLT(const FFloat4 A, const FFloat4 B) { return _mm_cmplt_ps(A, B); }
+		inline FMask4 CompareLE(const FFloat4 A, const FFloat4 B) { return _mm_cmple_ps(A, B); }
+		inline FMask4 CompareGE(const FFloat4 A, const FFloat4 B) { return _mm_cmpge_ps(A, B); }
+		inline FMask4 Or(const FMask4 A, const FMask4 B) { return _mm_or_ps(A, B); }
+		inline FFloat4 Select(const FMask4 Mask, const FFloat4 A, const FFloat4 B) { return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B)); }
+		inline int MaskBits(const FMask4 Mask) { return _mm_movemask_ps(Mask); }
+#else
+		struct FFloat4
+		{
+			float Lanes[Width];
+		};
+
+		struct FMask4
+		{
+			bool Lanes[Width];
+		};
+
+		template <typename FunctionType>
+		inline FFloat4 Map(FunctionType&& Function)
+		{
+			FFloat4 Result;
+			for (int Lane = 0; Lane < Width; ++Lane)
+			{
+				Result.Lanes[Lane] = Function(Lane);
+			}
+			return Result;
+		}
+
+		template <typename FunctionType>
+		inline FMask4 MapMask(FunctionType&& Function)
+		{
+			FMask4 Result;
+			for (int Lane = 0; Lane < Width; ++Lane)
+			{
+				Result.Lanes[Lane] = Function(Lane);
+			}
+			return Result;
+		}
+
+		inline FFloat4 Load(const float* Source) { return Map([&](const int L) { return Source[L]; }); }
+		inline void Store(const FFloat4& Value, float* Destination) { for (int L = 0; L < Width; ++L) { Destination[L] = Value.Lanes[L]; } }
+		inline FFloat4 Set1(const float Value) { return Map([&](int) { return Value; }); }
+		inline FFloat4 Add(const FFloat4& A, const FFloat4& B) { return Map([&](const int L) { return A.Lanes[L] + B.Lanes[L]; }); }
+		inline FFloat4 Subtract(const FFloat4& A, const FFloat4& B) { return Map([&](const int L) { return A.Lanes[L] - B.Lanes[L]; }); }
+		inline FFloat4 Multiply(const FFloat4& A, const FFloat4& B) { return Map([&](const int L) { return A.Lanes[L] * B.Lanes[L]; }); }
+		inline FFloat4 Divide(const FFloat4& A, const FFloat4& B) { return Map([&](const int L) { return A.Lanes[L] / B.Lanes[L]; }); }
+		inline FFloat4 Min(const FFloat4& A, const FFloat4& B) { return Map([&](const int L) { return A.Lanes[L] < B.Lanes[L] ? A.Lanes[L] : B.Lanes[L]; }); }
+		inline FFloat4 Max(const FFloat4& A, const FFloat4& B) { return Map([&](const int L) { return A.Lanes[L] > B.Lanes[L] ? A.Lanes[L] : B.Lanes[L]; }); }
+		inline FFloat4 Sqrt(const FFloat4& Value) { return Map([&](const int L) { return std::sqrt(Value.Lanes[L]); }); }
+		inline FFloat4 Abs(const FFloat4& Value) { return Map([&](const int L) { return std::abs(Value.Lanes[L]); }); }
+		inline FFloat4 Negate(const FFloat4& Value) { return Map([&](const int L) { return -Value.Lanes[L]; }); }
+		inline FMask4 CompareLT(const FFloat4& A, const FFloat4& B) { return MapMask([&](const int L) { return A.Lanes[L] < B.Lanes[L]; }); }
+		inline FMask4 CompareLE(const FFloat4& A, const FFloat4& B) { return MapMask([&](const int L) { return A.Lanes[L] <= B.Lanes[L]; }); }
+		inline FMask4 CompareGE(const FFloat4& A, const FFloat4& B) { return MapMask([&](const int L) { return A.Lanes[L] >= B.Lanes[L]; }); }
+		inline FMask4 Or(const FMask4& A, const FMask4& B) { return MapMask([&](const int L) { return A.Lanes[L] || B.Lanes[L]; }); }
+		inline FFloat4 Select(const FMask4& Mask, const FFloat4& A, const FFloat4& B) { return Map([&](const int L) { return Mask.Lanes[L] ? A.Lanes[L] : B.Lanes[L]; }); }
+		inline int MaskBits(const FMask4& Mask)
+		{
+			int Bits = 0;
+			for (int L = 0; L < Width; ++L)
+			{
+				Bits |= Mask.Lanes[L] ? 1 << L : 0;
+			}
+			return Bits;
+		}
+#endif
+
+		inline FFloat4 MultiplyAdd(const FFloat4& A, const FFloat4& B, const FFloat4& C)
+		{
+			return Add(Multiply(A, B), C);
+		}
+
+		// Abramowitz and Stegun 4.4.46, absolute error below 2e-8 on [-1, 1]
+		inline FFloat4 ACos(const FFloat4& Value)
+		{
+			const FFloat4 One = Set1(1.0f);
+			const FFloat4 X = Min(Abs(Value), One);
+			FFloat4 Polynomial = Set1(-0.0012624911f);
+			Polynomial = MultiplyAdd(Polynomial, X, Set1(0.0066700901f));
+			Polynomial = MultiplyAdd(Polynomial, X, Set1(-0.0170881256f));
+			Polynomial = MultiplyAdd(Polynomial, X, Set1(0.0308918810f));
+			Polynomial = MultiplyAdd(Polynomial, X, Set1(-0.0501743046f));
+			Polynomial = MultiplyAdd(Polynomial, X, Set1(0.0889789874f));
+			Polynomial = MultiplyAdd(Polynomial, X, Set1(-0.2145988016f));
+			Polynomial = MultiplyAdd(Polynomial, X, Set1(1.5707963050f));
+			const FFloat4 Result = Multiply(Sqrt(Subtract(One, X)), Polynomial);
+			return Select(CompareLT(Value, Set1(0.0f)), Subtract(Set1(Pi), Result), Result);
+		}
+
+		inline FFloat4 ASin(const FFloat4& Value)
+		{
+			return Subtract(Set1(0.5f * Pi), ACos(Value));
+		}
+
+		// Taylor series up to x^11, absolute error below 1e-7 on [-Pi / 2, Pi / 2], which is all the slerp needs
+		inline FFloat4 Sin(const FFloat4& Value)
+		{
+			const FFloat4 X2 = Multiply(Value, Value);
+			FFloat4 Polynomial = Set1(-1.0f / 39916800.0f);
+			Polynomial = MultiplyAdd(Polynomial, X2, Set1(1.0f / 362880.0f));
+			Polynomial = MultiplyAdd(Polynomial, X2, Set1(-1.0f / 5040.0f));
+			Polynomial = MultiplyAdd(Polynomial, X2, Set1(1.0f / 120.0f));
+			Polynomial = MultiplyAdd(Polynomial, X2, Set1(-1.0f / 6.0f));
+			Polynomial = MultiplyAdd(Polynomial, X2, Set1(1.0f));
+			return Multiply(Value, Polynomial);
+		}
+
+		inline FFloat4 GetInterpolationAlpha(const FFloat4& DeltaTime, const float InterpolationSpeed)
+		{
+			return Min(Max(Multiply(DeltaTime, Set1(InterpolationSpeed)), Set1(0.0f)), Set1(1.0f));
+		}
+
+		// Same as InterpTo followed by differentiation, bit-compatible with GetSmoothedDerivative
+		inline FFloat4 GetSmoothedDerivative(const FFloat4& Current,
+		                                     FFloat4& InOutPrevious,
+		                                     const FFloat4& DeltaTime,
+		                                     const FFloat4& Alpha)
+		{
+			const FFloat4 Distance = Subtract(Current, InOutPrevious);
+			const FMask4 SnapMask = CompareLT(Multiply(Distance, Distance), Set1(SmallNumber));
+			const FFloat4 SmoothedValue = Select(SnapMask, Current, Add(InOutPrevious, Multiply(Distance, Alpha)));
+			const FFloat4 Derivative = Divide(Subtract(SmoothedValue, InOutPrevious), DeltaTime);
+			InOutPrevious = SmoothedValue;
+			return Derivative;
+		}
+
+		// Velocity -> acceleration -> jerk chain shared by linear and angular motion, four lanes of signed channels
+		struct FDerivatives
+		{
+			float Velocity[Width];
+			float Acceleration[Width];
+			float Jerk[Width];
+		};
+
+		inline void CalculateDerivatives(const FFloat4& VelocityNormalized,
+		                                 float* PreviousVelocities,
+		                                 float* PreviousAccelerations,
+		                                 const FFloat4& DeltaTime,
+		                                 const float VelocityInterpolationSpeed,
+		                                 const float AccelerationInterpolationSpeed,
+		                                 FDerivatives& OutDerivatives)
+		{
+			FFloat4 PreviousVelocity = Load(PreviousVelocities);
+			FFloat4 PreviousAcceleration = Load(PreviousAccelerations);
+
+			const FFloat4 AccelerationNormalized = Divide(
+				GetSmoothedDerivative(VelocityNormalized,
+				                      PreviousVelocity,
+				                      DeltaTime,
+				                      GetInterpolationAlpha(DeltaTime, VelocityInterpolationSpeed)),
+				Set1(VelocityInterpolationSpeed));
+			const FFloat4 JerkNormalized = Divide(
+				GetSmoothedDerivative(AccelerationNormalized,
+				                      PreviousAcceleration,
+				                      DeltaTime,
+				                      GetInterpolationAlpha(DeltaTime, AccelerationInterpolationSpeed)),
+				Set1(AccelerationInterpolationSpeed));
+
+			Store(PreviousVelocity, PreviousVelocities);
+			Store(PreviousAcceleration, PreviousAccelerations);
+			Store(VelocityNormalized, OutDerivatives.Velocity);
+			Store(AccelerationNormalized, OutDerivatives.Acceleration);
+			Store(JerkNormalized, OutDerivatives.Jerk);
+		}
+
+		// Linear motion of four consecutive objects. Distances run in single precision, so velocities match the
+		// per-object kernel within float rounding, previous locations are written back exactly like InterpTo does.
+		template <typename VectorType, typename ConfigType, typename MotionDataType>
+		void CalculateLinearMotionData(const VectorType* CurrentLocations,
+		                               const float* DeltaTimes,
+		                               const ConfigType& Config,
+		                               VectorType* PreviousLocations,
+		                               float* PreviousLinearVelocities,
+		                               float* PreviousLinearAccelerations,
+		                               MotionDataType* OutMotionData)
+		{
+			using FAdapter = TVectorAdapter<VectorType>;
+
+			// Differences are small, so they survive the conversion to float even if the locations themselves don't
+			float DistanceX[Width];
+			float DistanceY[Width];
+			float DistanceZ[Width];
+			for (int Lane = 0; Lane < Width; ++Lane)
+			{
+				FAdapter::Difference(CurrentLocations[Lane], PreviousLocations[Lane], DistanceX[Lane], DistanceY[Lane], DistanceZ[Lane]);
+			}
+
+			const FFloat4 DeltaTime = Load(DeltaTimes);
+			const FFloat4 X = Load(DistanceX);
+			const FFloat4 Y = Load(DistanceY);
+			const FFloat4 Z = Load(DistanceZ);
+			const FFloat4 DistanceSquared = MultiplyAdd(X, X, MultiplyAdd(Y, Y, Multiply(Z, Z)));
+			const FFloat4 Alpha = GetInterpolationAlpha(DeltaTime, Config.LocationInterpolationSpeed);
+
+			// Same threshold as InterpTo, snapped lanes move all the way to the target
+			const FFloat4 Scale = Select(CompareLT(DistanceSquared, Set1(KindaSmallNumber)), Set1(1.0f), Alpha);
+
+			FFloat4 VelocityNormalized = Divide(Divide(Multiply(Sqrt(DistanceSquared), Scale), DeltaTime), Set1(Config.MaxLinearVelocity));
+			if (Config.bClampLinearVelocity)
+			{
+				VelocityNormalized = Min(Set1(1.0f), VelocityNormalized);
+			}
+
+			for (int Lane = 0; Lane < Width; ++Lane)
+			{
+				PreviousLocations[Lane] = FAdapter::InterpTo(PreviousLocations[Lane], CurrentLocations[Lane], DeltaTimes[Lane], Config.LocationInterpolationSpeed);
+			}
+
+			FDerivatives Derivatives;
+			CalculateDerivatives(VelocityNormalized,
+			                     PreviousLinearVelocities,
+			                     PreviousLinearAccelerations,
+			                     DeltaTime,
+			                     Config.LinearVelocityInterpolationSpeed,
+			                     Config.LinearAccelerationInterpolationSpeed,
+			                     Derivatives);
+
+			for (int Lane = 0; Lane < Width; ++Lane)
+			{
+				OutMotionData[Lane].LinearVelocityNormalized = Derivatives.Velocity[Lane];
+				SetLinearDerivatives(OutMotionData[Lane], Derivatives.Acceleration[Lane], Derivatives.Jerk[Lane]);
+			}
+		}
+
+		// Angular motion of four consecutive objects with vectorized QInterpTo and AngularDistance.
+		// Runs in single precision with polynomial acos and sin, velocities match the per-object kernel within 1e-6.
+		template <typename QuatType, typename ConfigType, typename MotionDataType>
+		void CalculateAngularMotionData(const QuatType* CurrentRotations,
+		                                const float* DeltaTimes,
+		                                const ConfigType& Config,
+		                                QuatType* PreviousRotations,
+		                                float* PreviousAngularVelocities,
+		                                float* PreviousAngularAccelerations,
+		                                MotionDataType* OutMotionData)
+		{
+			using FAdapter = TQuatAdapter<QuatType>;
+
+			float PreviousX[Width], PreviousY[Width], PreviousZ[Width], PreviousW[Width];
+			float CurrentX[Width], CurrentY[Width], CurrentZ[Width], CurrentW[Width];
+			for (int Lane = 0; Lane < Width; ++Lane)
+			{
+				FAdapter::ToFloats(PreviousRotations[Lane], PreviousX[Lane], PreviousY[Lane], PreviousZ[Lane], PreviousW[Lane]);
+				FAdapter::ToFloats(CurrentRotations[Lane], CurrentX[Lane], CurrentY[Lane], CurrentZ[Lane], CurrentW[Lane]);
+			}
+
+			const FFloat4 PX = Load(PreviousX);
+			const FFloat4 PY = Load(PreviousY);
+			const FFloat4 PZ = Load(PreviousZ);
+			const FFloat4 PW = Load(PreviousW);
+			const FFloat4 CX = Load(CurrentX);
+			const FFloat4 CY = Load(CurrentY);
+			const FFloat4 CZ = Load(CurrentZ);
+			const FFloat4 CW = Load(CurrentW);
+			const FFloat4 Zero = Set1(0.0f);
+			const FFloat4 One = Set1(1.0f);
+			const FFloat4 DeltaTime = Load(DeltaTimes);
+			const FFloat4 Alpha = GetInterpolationAlpha(DeltaTime, Config.RotationInterpolationSpeed);
+
+			// Equal rotations snap to the target
+			const FFloat4 Tolerance = Set1(KindaSmallNumber);
+			const FFloat4 MaxDifference = Max(Max(Abs(Subtract(PX, CX)), Abs(Subtract(PY, CY))), Max(Abs(Subtract(PZ, CZ)), Abs(Subtract(PW, CW))));
+			const FFloat4 MaxSum = Max(Max(Abs(Add(PX, CX)), Abs(Add(PY, CY))), Max(Abs(Add(PZ, CZ)), Abs(Add(PW, CW))));
+			const FMask4 SnapMask = Or(CompareLE(MaxDifference, Tolerance), CompareLE(MaxSum, Tolerance));
+
+			// Slerp
+			const FFloat4 RawCosom = MultiplyAdd(PX, CX, MultiplyAdd(PY, CY, MultiplyAdd(PZ, CZ, Multiply(PW, CW))));
+			const FFloat4 Cosom = Abs(RawCosom);
+			const FFloat4 Omega = ACos(Cosom);
+			const FFloat4 InverseSin = Divide(One, Sin(Omega));
+			const FFloat4 OneMinusAlpha = Subtract(One, Alpha);
+			const FMask4 UseSinMask = CompareLT(Cosom, Set1(0.9999f));
+			const FFloat4 Scale0 = Select(UseSinMask, Multiply(Sin(Multiply(OneMinusAlpha, Omega)), InverseSin), OneMinusAlpha);
+			const FFloat4 UnsignedScale1 = Select(UseSinMask, Multiply(Sin(Multiply(Alpha, Omega)), InverseSin), Alpha);
+			const FFloat4 Scale1 = Select(CompareGE(RawCosom, Zero), UnsignedScale1, Negate(UnsignedScale1));
+
+			FFloat4 SX = MultiplyAdd(Scale0, PX, Multiply(Scale1, CX));
+			FFloat4 SY = MultiplyAdd(Scale0, PY, Multiply(Scale1, CY));
+			FFloat4 SZ = MultiplyAdd(Scale0, PZ, Multiply(Scale1, CZ));
+			FFloat4 SW = MultiplyAdd(Scale0, PW, Multiply(Scale1, CW));
+
+			// Normalization, degenerate results become identity
+			const FFloat4 SquareSum = MultiplyAdd(SX, SX, MultiplyAdd(SY, SY, MultiplyAdd(SZ, SZ, Multiply(SW, SW))));
+			const FMask4 DegenerateMask = CompareLT(SquareSum, Set1(SmallNumber));
+			const FFloat4 InverseLength = Divide(One, Sqrt(SquareSum));
+			SX = Select(SnapMask, CX, Select(DegenerateMask, Zero, Multiply(SX, InverseLength)));
+			SY = Select(SnapMask, CY, Select(DegenerateMask, Zero, Multiply(SY, InverseLength)));
+			SZ = Select(SnapMask, CZ, Select(DegenerateMask, Zero, Multiply(SZ, InverseLength)));
+			SW = Select(SnapMask, CW, Select(DegenerateMask, One, Multiply(SW, InverseLength)));
+
+			// Angular distance from the chord between the quaternions instead of acos of their dot product,
+			// which loses most of its precision for the small angles a single update usually covers
+			const FFloat4 InnerProduct = MultiplyAdd(SX, PX, MultiplyAdd(SY, PY, MultiplyAdd(SZ, PZ, Multiply(SW, PW))));
+			const FFloat4 Sign = Select(CompareGE(InnerProduct, Zero), One, Set1(-1.0f));
+			const FFloat4 DX = Subtract(SX, Multiply(Sign, PX));
+			const FFloat4 DY = Subtract(SY, Multiply(Sign, PY));
+			const FFloat4 DZ = Subtract(SZ, Multiply(Sign, PZ));
+			const FFloat4 DW = Subtract(SW, Multiply(Sign, PW));
+			const FFloat4 HalfChord = Multiply(Sqrt(MultiplyAdd(DX, DX, MultiplyAdd(DY, DY, MultiplyAdd(DZ, DZ, Multiply(DW, DW))))), Set1(0.5f));
+			const FFloat4 Angle = Multiply(Set1(4.0f), ASin(HalfChord));
+			const FFloat4 Revolutions = Divide(Angle, Set1(2.0f * Pi)); // Convert radians to revolutions
+
+			FFloat4 VelocityNormalized = Divide(Divide(Revolutions, DeltaTime), Set1(Config.MaxAngularVelocity));
+			if (Config.bClampAngularVelocity)
+			{
+				VelocityNormalized = Min(One, VelocityNormalized);
+			}
+
+			float SmoothedX[Width], SmoothedY[Width], SmoothedZ[Width], SmoothedW[Width];
+			Store(SX, SmoothedX);
+			Store(SY, SmoothedY);
+			Store(SZ, SmoothedZ);
+			Store(SW, SmoothedW);
+			const int SnapBits = MaskBits(SnapMask);
+			for (int Lane = 0; Lane < Width; ++Lane)
+			{
+				PreviousRotations[Lane] = (SnapBits & (1 << Lane))
+					                          ? CurrentRotations[Lane]
+					                          : FAdapter::FromFloats(SmoothedX[Lane], SmoothedY[Lane], SmoothedZ[Lane], SmoothedW[Lane]);
+			}
+
+			FDerivatives Derivatives;
+			CalculateDerivatives(VelocityNormalized,
+			                     PreviousAngularVelocities,
+			                     PreviousAngularAccelerations,
+			                     DeltaTime,
+			                     Config.AngularVelocityInterpolationSpeed,
+			                     Config.AngularAccelerationInterpolationSpeed,
+			                     Derivatives);
+
+			for (int Lane = 0; Lane < Width; ++Lane)
+			{
+				OutMotionData[Lane].AngularVelocityNormalized = Derivatives.Velocity[Lane];
+				SetAngularDerivatives(OutMotionData[Lane], Derivatives.Acceleration[Lane], Derivatives.Jerk[Lane]);
+			}
+		}
+	}
+
+	/* Structure-of-arrays batches */
+
+	// Raw view of service data stored as structure of arrays in the compact layout: single precision transforms with
+	// locations relative to the origin, and packed motion data. Inputs are converted as they're read, so the origin
+	// should stay close to the objects for their locations to keep the precision of the input type.
+	// Filter states are only read by filters with bHasState and fixed step state only with a fixed time step, so they may
+	// be null otherwise.
+	template <typename VectorType, typename QuatType>
+	struct TBatchView
+	{
+		VectorType Origin{};
+		bool* SetPreviousTransformToCurrent = nullptr;
+		FFloatVector3* PreviousLocations = nullptr;
+		FFloatQuat4* PreviousRotations = nullptr;
+		float* PreviousLinearVelocities = nullptr;
+		float* PreviousLinearAccelerations = nullptr;
+		float* PreviousAngularVelocities = nullptr;
+		float* PreviousAngularAccelerations = nullptr;
+		FFilterState* LinearVelocityFilterStates = nullptr;
+		FFilterState* LinearAccelerationFilterStates = nullptr;
+		FFilterState* AngularVelocityFilterStates = nullptr;
+		FFilterState* AngularAccelerationFilterStates = nullptr;
+		float* TimeAccumulators = nullptr;
+		FPackedMotionData* FixedStepMotionData = nullptr;
+		// Last transforms passed in, only EvaluateIndices reads and writes them
+		FFloatVector3* PreviousInputLocations = nullptr;
+		FFloatQuat4* PreviousInputRotations = nullptr;
+	};
+
+	// Location relative to the origin, differenced in the precision of the input type before it's rounded
+	template <typename VectorType>
+	FFloatVector3 ToRelativeLocation(const VectorType& Location, const VectorType& Origin)
+	{
+		FFloatVector3 RelativeLocation;
+		TVectorAdapter<VectorType>::Difference(Location, Origin, RelativeLocation.X, RelativeLocation.Y, RelativeLocation.Z);
+		return RelativeLocation;
+	}
+
+	template <typename QuatType>
+	FFloatQuat4 ToFloatRotation(const QuatType& Rotation)
+	{
+		FFloatQuat4 FloatRotation;
+		TQuatAdapter<QuatType>::ToFloats(Rotation, FloatRotation.X, FloatRotation.Y, FloatRotation.Z, FloatRotation.W);
+		return FloatRotation;
+	}
+
+	// Filter state of an entry, or Unused for filters without state, whose batches may not store any
+	template <typename FilterType>
+	FFilterState& GetFilterState(FFilterState* States, const int Index, FFilterState& Unused)
+	{
+		if constexpr (FilterType::bHasState)
+		{
+			return States[Index];
+		}
+		else
+		{
+			return Unused;
+		}
+	}
+
+	// EvaluateRange with the given filter, vectorized only if the filter has SIMD kernels
+	template <typename FilterType, typename VectorType, typename QuatType, typename ConfigType, typename OutputFunctionType>
+	void EvaluateRangeWithFilter(const TBatchView<VectorType, QuatType>& Batch,
+	                             const int Begin,
+	                             const int End,
+	                             const VectorType* Locations,
+	                             const QuatType* Rotations,
+	                             const float DeltaTime,
+	                             const ConfigType& Config,
+	                             bool bVectorized,
+	                             OutputFunctionType& OutputFunction)
+	{
+		constexpr int Width = Simd::Width;
+		bVectorized = bVectorized && FilterType::bHasSimdKernel;
+		FFilterState UnusedState;
+
+		const auto SetPreviousTransformIfNeeded = [&](const int Index)
+		{
+			if (Batch.SetPreviousTransformToCurrent[Index])
+			{
+				Batch.PreviousLocations[Index] = ToRelativeLocation(Locations[Index], Batch.Origin);
+				Batch.PreviousRotations[Index] = ToFloatRotation(Rotations[Index]);
+				Batch.SetPreviousTransformToCurrent[Index] = false;
+			}
+		};
+
+		// Evaluates a whole group of four, all lanes must advance by their own Delta Time exactly once
+		const auto EvaluateGroup = [&](const int Index, const float* DeltaTimes, FPackedMotionData* OutMotionData)
+		{
+			if (Config.bCalculateLinearMotion)
+			{
+				FFloatVector3 CurrentLocations[Width];
+				for (int Lane = 0; Lane < Width; ++Lane)
+				{
+					CurrentLocations[Lane] = ToRelativeLocation(Locations[Index + Lane], Batch.Origin);
+				}
+				Simd::CalculateLinearMotionData(CurrentLocations,
+				                                DeltaTimes,
+				                                Config,
+				                                &Batch.PreviousLocations[Index],
+				                                &Batch.PreviousLinearVelocities[Index],
+				                                &Batch.PreviousLinearAccelerations[Index],
+				                                OutMotionData);
+			}
+			if (Config.bCalculateAngularMotion)
+			{
+				FFloatQuat4 CurrentRotations[Width];
+				for (int Lane = 0; Lane < Width; ++Lane)
+				{
+					CurrentRotations[Lane] = ToFloatRotation(Rotations[Index + Lane]);
+				}
+				Simd::CalculateAngularMotionData(CurrentRotations,
+				                                 DeltaTimes,
+				                                 Config,
+				                                 &Batch.PreviousRotations[Index],
+				                                 &Batch.PreviousAngularVelocities[Index],
+				                                 &Batch.PreviousAngularAccelerations[Index],
+				                                 OutMotionData);
+			}
+		};
+
+		int Index = Begin;
+
+		if (Config.bUseFixedTimeStep)
+		{
+			const auto EvaluateSteps = [&](const int EntryIndex, const int Steps, const float StepTime)
+			{
+				CalculateMotionDataSteps<FilterType>(ToRelativeLocation(Locations[EntryIndex], Batch.Origin),
+				                                     ToFloatRotation(Rotations[EntryIndex]),
+				                                     Steps,
+				                                     StepTime,
+				                                     Config,
+				                                     Batch.PreviousLocations[EntryIndex],
+				                                     Batch.PreviousRotations[EntryIndex],
+				                                     Batch.PreviousLinearVelocities[EntryIndex],
+				                                     Batch.PreviousLinearAccelerations[EntryIndex],
+				                                     Batch.PreviousAngularVelocities[EntryIndex],
+				                                     Batch.PreviousAngularAccelerations[EntryIndex],
+				                                     GetFilterState<FilterType>(Batch.LinearVelocityFilterStates, EntryIndex, UnusedState),
+				                                     GetFilterState<FilterType>(Batch.LinearAccelerationFilterStates, EntryIndex, UnusedState),
+				                                     GetFilterState<FilterType>(Batch.AngularVelocityFilterStates, EntryIndex, UnusedState),
+				                                     GetFilterState<FilterType>(Batch.AngularAccelerationFilterStates, EntryIndex, UnusedState),
+				                                     Batch.FixedStepMotionData[EntryIndex]);
+			};
+
+			if (bVectorized)
+			{
+				for (; Index + Width <= End; Index += Width)
+				{
+					int Steps[Width];
+					float StepTimes[Width];
+					bool bSingleStep = true;
+					for (int Lane = 0; Lane < Width; ++Lane)
+					{
+						SetPreviousTransformIfNeeded(Index + Lane);
+						Steps[Lane] = ConsumeFixedSteps(Batch.TimeAccumulators[Index + Lane], DeltaTime, Config.FixedTimeStep, Config.MaxSubsteps, StepTimes[Lane]);
+						bSingleStep = bSingleStep && Steps[Lane] == 1;
+					}
+
+					if (bSingleStep)
+					{
+						FPackedMotionData MotionData[Width] = {};
+						EvaluateGroup(Index, StepTimes, MotionData);
+						for (int Lane = 0; Lane < Width; ++Lane)
+						{
+							Batch.FixedStepMotionData[Index + Lane] = MotionData[Lane];
+						}
+					}
+					else
+					{
+						for (int Lane = 0; Lane < Width; ++Lane)
+						{
+							EvaluateSteps(Index + Lane, Steps[Lane], StepTimes[Lane]);
+						}
+					}
+
+					for (int Lane = 0; Lane < Width; ++Lane)
+					{
+						OutputFunction(Index + Lane, Batch.FixedStepMotionData[Index + Lane]);
+					}
+				}
+			}
+
+			for (; Index < End; ++Index)
+			{
+				SetPreviousTransformIfNeeded(Index);
+
+				float StepTime;
+				const int Steps = ConsumeFixedSteps(Batch.TimeAccumulators[Index], DeltaTime, Config.FixedTimeStep, Config.MaxSubsteps, StepTime);
+				EvaluateSteps(Index, Steps, StepTime);
+
+				OutputFunction(Index, Batch.FixedStepMotionData[Index]);
+			}
+
+			return;
+		}
+
+		if (bVectorized)
+		{
+			const float DeltaTimes[Width] = {DeltaTime, DeltaTime, DeltaTime, DeltaTime};
+
+			for (; Index + Width <= End; Index += Width)
+			{
+				for (int Lane = Index; Lane < Index + Width; ++Lane)
+				{
+					SetPreviousTransformIfNeeded(Lane);
+				}
+
+				FPackedMotionData MotionData[Width] = {};
+				EvaluateGroup(Index, DeltaTimes, MotionData);
+
+				for (int Lane = 0; Lane < Width; ++Lane)
+				{
+					OutputFunction(Index + Lane, MotionData[Lane]);
+				}
+			}
+		}
+
+		for (; Index < End; ++Index)
+		{
+			SetPreviousTransformIfNeeded(Index);
+
+			FPackedMotionData MotionData{};
+
+			if (Config.bCalculateLinearMotion)
+			{
+				CalculateLinearMotionData<FilterType>(ToRelativeLocation(Locations[Index], Batch.Origin),
+				                                      DeltaTime,
+				                                      Config,
+				                                      Batch.PreviousLocations[Index],
+				                                      Batch.PreviousLinearVelocities[Index],
+				                                      Batch.PreviousLinearAccelerations[Index],
+				                                      GetFilterState<FilterType>(Batch.LinearVelocityFilterStates, Index, UnusedState),
+				                                      GetFilterState<FilterType>(Batch.LinearAccelerationFilterStates, Index, UnusedState),
+				                                      MotionData);
+			}
+			if (Config.bCalculateAngularMotion)
+			{
+				CalculateAngularMotionData<FilterType>(ToFloatRotation(Rotations[Index]),
+				                                       DeltaTime,
+				                                       Config,
+				                                       Batch.PreviousRotations[Index],
+				                                       Batch.PreviousAngularVelocities[Index],
+				                                       Batch.PreviousAngularAccelerations[Index],
+				                                       GetFilterState<FilterType>(Batch.AngularVelocityFilterStates, Index, UnusedState),
+				                                       GetFilterState<FilterType>(Batch.AngularAccelerationFilterStates, Index, UnusedState),
+				                                       MotionData);
+			}
+
+			OutputFunction(Index, MotionData);
+		}
+	}
+
+	// Evaluates entries [Begin, End) of a batch, calling OutputFunction(Index, PackedMotionData) for each of them.
+	// Vectorized evaluation handles whole groups of four and falls back to the per-object kernels for the remainder.
+	// With a fixed time step, groups where every entry takes exactly one step are still vectorized.
+	template <typename VectorType, typename QuatType, typename ConfigType, typename OutputFunctionType>
+	void EvaluateRange(const TBatchView<VectorType, QuatType>& Batch,
+	                   const int Begin,
+	                   const int End,
+	                   const VectorType* Locations,
+	                   const QuatType* Rotations,
+	                   const float DeltaTime,
+	                   const ConfigType& Config,
+	                   const bool bVectorized,
+	                   OutputFunctionType& OutputFunction)
+	{
+		DispatchFilter(Config, [&](auto Filter)
+		{
+			EvaluateRangeWithFilter<decltype(Filter)>(Batch, Begin, End, Locations, Rotations, DeltaTime, Config, bVectorized, OutputFunction);
+		});
+	}
+
+	// EvaluateIndices with the given filter
+	template <typename FilterType, typename VectorType, typename QuatType, typename ConfigType, typename OutputFunctionType>
+	void EvaluateIndicesWithFilter(const TBatchView<VectorType, QuatType>& Batch,
+	                               const int* Indices,
+	                               const int Count,
+	                               const VectorType* Locations,
+	                               const QuatType* Rotations,
+	                               const float* DeltaTimes,
+	                               const int* Frames,
+	                               const ConfigType& Config,
+	                               OutputFunctionType& OutputFunction)
+	{
+		FFilterState UnusedState;
+		for (int Position = 0; Position < Count; ++Position)
+		{
+			const int Index = Indices[Position];
+			const FFloatVector3 Location = ToRelativeLocation(Locations[Index], Batch.Origin);
+			const FFloatQuat4 Rotation = ToFloatRotation(Rotations[Index]);
+
+			if (Batch.SetPreviousTransformToCurrent[Index])
+			{
+				Batch.PreviousLocations[Index] = Location;
+				Batch.PreviousRotations[Index] = Rotation;
+				Batch.PreviousInputLocations[Index] = Location;
+				Batch.PreviousInputRotations[Index] = Rotation;
+				Batch.SetPreviousTransformToCurrent[Index] = false;
+			}
+
+			int Steps;
+			float StepTime;
+			if (Config.bUseFixedTimeStep)
+			{
+				Steps = ConsumeFixedSteps(Batch.TimeAccumulators[Index], DeltaTimes[Index], Config.FixedTimeStep, Config.MaxSubsteps, StepTime);
+			}
+			else
+			{
+				Steps = Frames[Index];
+				StepTime = DeltaTimes[Index] / Steps;
+			}
+
+			// Every step chases the transform on a straight path from the previous input, instead of all of them chasing
+			// the new one, so an object moving at a constant velocity comes out the same at any update interval
+			FPackedMotionData MotionData{};
+			FPackedMotionData& OutMotionData = Config.bUseFixedTimeStep ? Batch.FixedStepMotionData[Index] : MotionData;
+			for (int Step = 1; Step <= Steps; ++Step)
+			{
+				const double Alpha = static_cast<double>(Step) / Steps;
+				CalculateMotionDataSteps<FilterType>(Step < Steps ? TVectorAdapter<FFloatVector3>::Lerp(Batch.PreviousInputLocations[Index], Location, Alpha) : Location,
+				                                     Step < Steps ? TQuatAdapter<FFloatQuat4>::Slerp(Batch.PreviousInputRotations[Index], Rotation, Alpha) : Rotation,
+				                                     1,
+				                                     StepTime,
+				                                     Config,
+				                                     Batch.PreviousLocations[Index],
+				                                     Batch.PreviousRotations[Index],
+				                                     Batch.PreviousLinearVelocities[Index],
+				                                     Batch.PreviousLinearAccelerations[Index],
+				                                     Batch.PreviousAngularVelocities[Index],
+				                                     Batch.PreviousAngularAccelerations[Index],
+				                                     GetFilterState<FilterType>(Batch.LinearVelocityFilterStates, Index, UnusedState),
+				                                     GetFilterState<FilterType>(Batch.LinearAccelerationFilterStates, Index, UnusedState),
+				                                     GetFilterState<FilterType>(Batch.AngularVelocityFilterStates, Index, UnusedState),
+				                                     GetFilterState<FilterType>(Batch.AngularAccelerationFilterStates, Index, UnusedState),
+				                                     OutMotionData);
+			}
+
+			// Without a due fixed step the path continues from the same input on the next update
+			if (Steps > 0)
+			{
+				Batch.PreviousInputLocations[Index] = Location;
+				Batch.PreviousInputRotations[Index] = Rotation;
+			}
+			OutputFunction(Index, OutMotionData);
+		}
+	}
+
+	// Evaluates selected entries of a batch, each advancing by its own time since its last update, e.g. when updates are
+	// spread over frames. Time of an entry is split into one step per frame it covers, and the steps retrace a straight
+	// path from the transform of its previous update, so velocity, acceleration and jerk of an object moving at a constant
+	// velocity come out the same as if it had been updated every frame. Indices must be distinct.
+	// DeltaTimes and Frames are per entry, indexed like the batch, and must be > 0. Runs the per-object kernels.
+	template <typename VectorType, typename QuatType, typename ConfigType, typename OutputFunctionType>
+	void EvaluateIndices(const TBatchView<VectorType, QuatType>& Batch,
+	                     const int* Indices,
+	                     const int Count,
+	                     const VectorType* Locations,
+	                     const QuatType* Rotations,
+	                     const float* DeltaTimes,
+	                     const int* Frames,
+	                     const ConfigType& Config,
+	                     OutputFunctionType& OutputFunction)
+	{
+		DispatchFilter(Config, [&](auto Filter)
+		{
+			EvaluateIndicesWithFilter<decltype(Filter)>(Batch, Indices, Count, Locations, Rotations, DeltaTimes, Frames, Config, OutputFunction);
+		});
+	}
+
+	// EvaluateRangeFromVelocity with the given filter
+	template <typename FilterType, typename VectorType, typename QuatType, typename ConfigType, typename OutputFunctionType>
+	void EvaluateRangeFromVelocityWithFilter(const TBatchView<VectorType, QuatType>& Batch,
+	                                         const int Begin,
+	                                         const int End,
+	                                         const VectorType* LinearVelocities,
+	                                         const VectorType* AngularVelocities,
+	                                         const float DeltaTime,
+	                                         const ConfigType& Config,
+	                                         OutputFunctionType& OutputFunction)
+	{
+		using FAdapter = TVectorAdapter<VectorType>;
+
+		FFilterState UnusedState;
+		for (int Index = Begin; Index < End; ++Index)
+		{
+			const float LinearSpeed = static_cast<float>(FAdapter::Size(LinearVelocities[Index]));
+			const float AngularSpeed = static_cast<float>(FAdapter::Size(AngularVelocities[Index]) / (2.0f * Pi)); // Radians to revolutions
+
+			int Steps = 1;
+			float StepTime = DeltaTime;
+			if (Config.bUseFixedTimeStep)
+			{
+				Steps = ConsumeFixedSteps(Batch.TimeAccumulators[Index], DeltaTime, Config.FixedTimeStep, Config.MaxSubsteps, StepTime);
+			}
+
+			FPackedMotionData MotionData{};
+			FPackedMotionData& OutMotionData = Config.bUseFixedTimeStep ? Batch.FixedStepMotionData[Index] : MotionData;
+			CalculateMotionDataFromVelocitySteps<FilterType>(LinearSpeed,
+			                                                 AngularSpeed,
+			                                                 Steps,
+			                                                 StepTime,
+			                                                 Config,
+			                                                 Batch.PreviousLinearVelocities[Index],
+			                                                 Batch.PreviousLinearAccelerations[Index],
+			                                                 Batch.PreviousAngularVelocities[Index],
+			                                                 Batch.PreviousAngularAccelerations[Index],
+			                                                 GetFilterState<FilterType>(Batch.LinearVelocityFilterStates, Index, UnusedState),
+			                                                 GetFilterState<FilterType>(Batch.LinearAccelerationFilterStates, Index, UnusedState),
+			                                                 GetFilterState<FilterType>(Batch.AngularVelocityFilterStates, Index, UnusedState),
+			                                                 GetFilterState<FilterType>(Batch.AngularAccelerationFilterStates, Index, UnusedState),
+			                                                 OutMotionData);
+			OutputFunction(Index, OutMotionData);
+		}
+	}
+
+	// Same as EvaluateRange for sources that know their velocity, angular velocities are in rad/s.
+	// Previous transforms of the batch are untouched. Runs the per-object kernel, there's no transform math left to vectorize.
+	template <typename VectorType, typename QuatType, typename ConfigType, typename OutputFunctionType>
+	void EvaluateRangeFromVelocity(const TBatchView<VectorType, QuatType>& Batch,
+	                               const int Begin,
+	                               const int End,
+	                               const VectorType* LinearVelocities,
+	                               const VectorType* AngularVelocities,
+	                               const float DeltaTime,
+	                               const ConfigType& Config,
+	                               OutputFunctionType& OutputFunction)
+	{
+		DispatchFilter(Config, [&](auto Filter)
+		{
+			EvaluateRangeFromVelocityWithFilter<decltype(Filter)>(Batch, Begin, End, LinearVelocities, AngularVelocities, DeltaTime, Config, OutputFunction);
+		});
+	}
+}
@@ -0,0 +1,64 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MotionIntensityCore.h"
+
+// Plugs engine math types into MotionIntensityCore, so the core kernels use FMath semantics for FVector and FQuat
+namespace MotionIntensityCore
+{
+	template <>
+	struct TVectorAdapter<FVector>
+	{
+		FORCEINLINE static FVector InterpTo(const FVector& Current, const FVector& Target, const float DeltaTime, const float InterpSpeed)
+		{
+			return FMath::VInterpTo(Current, Target, DeltaTime, InterpSpeed);
+		}
+
+		FORCEINLINE static double Distance(const FVector& A, const FVector& B)
+		{
+			return (A - B).Length();
+		}
+
+		FORCEINLINE static void Difference(const FVector& A, const FVector& B, float& OutX, float& OutY, float& OutZ)
+		{
+			const FVector Distance = A - B;
+			OutX = static_cast<float>(Distance.X);
+			OutY = static_cast<float>(Distance.Y);
+			OutZ = static_cast<float>(Distance.Z);
+		}
+
+		FORCEINLINE static double Size(const FVector& Vector)
+		{
+			return Vector.Length();
+		}
+	};
+
+	template <>
+	struct TQuatAdapter<FQuat>
+	{
+		FORCEINLINE static FQuat InterpTo(const FQuat& Current, const FQuat& Target, const float DeltaTime, const float InterpSpeed)
+		{
+			return FMath::QInterpTo(Current, Target, DeltaTime, InterpSpeed);
+		}
+
+		FORCEINLINE static double AngularDistance(const FQuat& A, const FQuat& B)
+		{
+			return A.AngularDistance(B);
+		}
+
+		FORCEINLINE static void ToFloats(const FQuat& Quat, float& OutX, float& OutY, float& OutZ, float& OutW)
+		{
+			OutX = static_cast<float>(Quat.X);
+			OutY = static_cast<float>(Quat.Y);
+			OutZ = static_cast<float>(Quat.Z);
+			OutW = static_cast<float>(Quat.W);
+		}
+
+		FORCEINLINE static FQuat FromFloats(const float X, const float Y, const float Z, const float W)
+		{
+			return FQuat(X, Y, Z, W);
+		}
+	};
+}
@@ -0,0 +1,64 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "MotionIntensity.h"
+#include "MotionIntensityReplication.generated.h"
+
+// Motion data and overall motion intensity in a compact form for replication.
+// Normalized channels are quantized to 10 bits in [0, MaxChannelValue], channels at zero aren't sent at all,
+// overall motion intensity is sent as a half float. Update() keeps the state unchanged for changes under a threshold,
+// so property replication skips it.
+USTRUCT()
+struct MOTIONINTENSITY_API FMotionIntensityReplicatedData
+{
+	GENERATED_BODY()
+
+	static constexpr int32 NumChannels = 10;
+	static constexpr int32 ChannelBits = 10;
+	static constexpr uint32 MaxQuantizedChannel = (1u << ChannelBits) - 1;
+	// Larger normalized values are saturated
+	static constexpr float MaxChannelValue = 2.0f;
+
+	FMotionIntensityReplicatedData() = default;
+	FMotionIntensityReplicatedData(const FMotionIntensityMotionData& MotionData, float InMotionIntensity);
+
+	// Replaces the state if any channel or motion intensity moved by more than the threshold, returns true if it did
+	bool Update(const FMotionIntensityMotionData& MotionData, float InMotionIntensity, float Threshold);
+
+	FMotionIntensityMotionData GetMotionData() const;
+	float GetMotionIntensity() const;
+
+	// Moves the smoothing state towards the replicated motion data, so local evaluation continues from it.
+	// Filters of the config are settled at the replicated values. Previous transform is left alone, clients track their own.
+	void ApplyTo(FMotionIntensityServiceData& ServiceData, const FMotionIntensityConfig& Config) const;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FMotionIntensityReplicatedData& Other) const
+	{
+		return MotionIntensity == Other.MotionIntensity && FMemory::Memcmp(Channels, Other.Channels, sizeof(Channels)) == 0;
+	}
+
+	bool operator!=(const FMotionIntensityReplicatedData& Other) const
+	{
+		return !(*this == Other);
+	}
+
+private:
+	// Quantized normalized channels in the order of FMotionIntensityMotionData
+	uint16 Channels[NumChannels] = {};
+
+	// Half float bits
+	uint16 MotionIntensity = 0;
+};
+
+template <>
+struct TStructOpsTypeTraits<FMotionIntensityReplicatedData> : public TStructOpsTypeTraitsBase2<FMotionIntensityReplicatedData>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
@@ -0,0 +1,89 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "MotionIntensityBatch.h"
+
+// Spreads updates of a batch over frames by significance, e.g. distant objects are evaluated at a fraction of the frame rate.
+// Every entry gets an update interval of 1, 2, 4... frames from its significance and a round-robin phase, so about the same
+// number of entries is evaluated every frame. Skipped entries accumulate their time, which is stepped once per skipped
+// frame on their next update along a straight path from their previous transform. Motion at a constant velocity comes out
+// the same at any update rate, curved motion is linearized between updates, so acceleration and jerk of fast turns are
+// underestimated at long intervals.
+class MOTIONINTENSITY_API FMotionIntensityScheduler
+{
+public:
+	// Significance is a value in [0, 1], entries at or above the first threshold update every frame, entries at or above
+	// the second one every 2 frames, and so on. Entries below all thresholds update every 2^Num() frames.
+	explicit FMotionIntensityScheduler(TArray<float> InSignificanceThresholds = {0.5f, 0.25f, 0.1f});
+
+	// Adds a new entry in its initial state and returns its index
+	int32 Add(float Significance = 1.0f);
+
+	// Removes the entry at the given index, the last entry is moved into its place
+	void RemoveAtSwap(int32 Index);
+
+	// Resets the entry at the given index to its initial state
+	void ResetEntry(int32 Index);
+
+	// Removes all entries
+	void Empty();
+
+	int32 Num() const
+	{
+		return Batch.Num();
+	}
+
+	// Sets the significance of the entry, the new interval applies from the next update
+	void SetSignificance(int32 Index, float Significance);
+
+	// Update interval of the entry in frames
+	int32 GetUpdateInterval(int32 Index) const;
+
+	// Significance from the distance to the closest view, 1 at the view and 0 at MaxDistance and beyond
+	static float GetDistanceSignificance(const FVector& Location, TArrayView<const FVector> ViewLocations, float MaxDistance);
+
+	// Advances one frame and evaluates the entries due this frame, inputs and outputs must have Num() elements.
+	// Outputs of entries that aren't due are left untouched, so pass the same arrays every frame.
+	// Returns false, evaluates nothing and doesn't advance if Delta Time, config or coefficients are invalid.
+	bool Update(TArrayView<const FVector> Locations,
+	            TArrayView<const FQuat> Rotations,
+	            float DeltaTime,
+	            const FMotionIntensityConfig& Config,
+	            const FMotionIntensityCompiledCoefficients& CompiledCoefficients,
+	            TArrayView<FMotionIntensityMotionData> OutMotionData,
+	            TArrayView<float> OutMotionIntensities);
+
+	// Entries evaluated by the last update
+	TArrayView<const int32> GetUpdatedIndices() const
+	{
+		return DueIndices;
+	}
+
+	// Service data storage, e.g. to read or overwrite the state of an entry
+	FMotionIntensityBatch& GetBatch()
+	{
+		return Batch;
+	}
+
+	const FMotionIntensityBatch& GetBatch() const
+	{
+		return Batch;
+	}
+
+private:
+	uint8 GetIntervalShift(float Significance) const;
+
+	TArray<float> SignificanceThresholds;
+	FMotionIntensityBatch Batch;
+
+	// Per entry, indexed like the batch
+	TArray<uint8> IntervalShifts;
+	TArray<uint32> Phases;
+	TArray<float> AccumulatedDeltaTimes;
+	TArray<int32> AccumulatedFrames;
+
+	TArray<int32> DueIndices;
+	uint32 FrameCounter = 0;
+	uint32 NextPhase = 0;
+};
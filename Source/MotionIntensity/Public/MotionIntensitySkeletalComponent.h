@@ -0,0 +1,123 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "MotionIntensityBatch.h"
+#include "MotionIntensitySkeletalComponent.generated.h"
+
+class USkeletalMeshComponent;
+class USkinnedAsset;
+
+// Tracks the motion intensity of several bones of a skeletal mesh, e.g. head and hands to drive camera shake.
+// Bone transforms are read from the mesh's component space buffer, or from its leader's if it follows a leader pose, and
+// evaluated in one batch, then reduced to aggregates.
+// Ticks after the mesh, in TG_PostPhysics.
+UCLASS(ClassGroup = (MotionIntensity), meta = (BlueprintSpawnableComponent))
+class MOTIONINTENSITY_API UMotionIntensitySkeletalComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMotionIntensitySkeletalComponent();
+
+	UFUNCTION(BlueprintCallable, Category = "Motion Intensity")
+	void SetPreset(UMotionIntensityPreset* NewPreset);
+
+	UFUNCTION(BlueprintPure, Category = "Motion Intensity")
+	UMotionIntensityPreset* GetPreset() const
+	{
+		return Preset;
+	}
+
+	// Sets the skeletal mesh whose bones are tracked, the owner's first skeletal mesh component is used if not set
+	UFUNCTION(BlueprintCallable, Category = "Motion Intensity")
+	void SetSkeletalMeshComponent(USkeletalMeshComponent* NewSkeletalMeshComponent);
+
+	// Skeletal mesh whose bones are tracked
+	UFUNCTION(BlueprintPure, Category = "Motion Intensity")
+	USkeletalMeshComponent* GetSkeletalMeshComponent() const;
+
+	// Sets the tracked bones and their weights in the weighted aggregate, missing weights are 1
+	UFUNCTION(BlueprintCallable, Category = "Motion Intensity")
+	void SetBones(const TArray<FName>& NewBoneNames, const TArray<float>& NewBoneWeights);
+
+	// Resets service data of all bones, next update will start from the current pose
+	UFUNCTION(BlueprintCallable, Category = "Motion Intensity")
+	void ResetMotionIntensity();
+
+	// Motion intensity of the given bone from the latest update, 0 if the bone isn't tracked
+	UFUNCTION(BlueprintPure, Category = "Motion Intensity")
+	float GetBoneMotionIntensity(FName BoneName) const;
+
+	// Motion data of every tracked bone from the latest update, in the order of Bone Names
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Motion Intensity")
+	TArray<FMotionIntensityMotionData> BoneMotionData;
+
+	// Overall motion intensity of every tracked bone from the latest update, in the order of Bone Names
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Motion Intensity")
+	TArray<float> BoneMotionIntensities;
+
+	// Largest motion intensity among the tracked bones
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Motion Intensity")
+	float MaxMotionIntensity = 0.0f;
+
+	// Root mean square of the motion intensities of the tracked bones
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Motion Intensity")
+	float RMSMotionIntensity = 0.0f;
+
+	// Weighted mean of the motion intensities of the tracked bones
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Motion Intensity")
+	float WeightedMotionIntensity = 0.0f;
+
+	// If true, bones are tracked in world space, so moving the whole mesh counts.
+	// Otherwise they are tracked relative to the mesh, e.g. to isolate animation from locomotion.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Motion Intensity")
+	bool bWorldSpace = true;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void ApplyWorldOffset(const FVector& InOffset, bool bWorldShift) override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Config and coefficients, defaults are used if not set
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Motion Intensity")
+	TObjectPtr<UMotionIntensityPreset> Preset;
+
+	// Tracked bones, bones missing from the mesh report no motion
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Motion Intensity")
+	TArray<FName> BoneNames;
+
+	// Weights of the tracked bones in the weighted aggregate, in the order of Bone Names, missing weights are 1
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Motion Intensity")
+	TArray<float> BoneWeights;
+
+	// Skeletal mesh whose bones are tracked, the owner's first skeletal mesh component is used if not set
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Motion Intensity")
+	TObjectPtr<USkeletalMeshComponent> SkeletalMeshComponent;
+
+private:
+	// Rebuilds the batch and bone indices for the current bones and mesh
+	void ResolveBones();
+
+	// Makes the tick wait for the mesh's pose
+	void UpdateTickPrerequisite();
+
+	void UpdateAggregates();
+
+	FMotionIntensityBatch Batch;
+
+	// Index of every tracked bone in the mesh's component space buffer, INDEX_NONE if missing
+	TArray<int32> BoneIndices;
+
+	// Asset the bone indices were resolved for, they are resolved again if the mesh changes
+	TWeakObjectPtr<const USkinnedAsset> ResolvedAsset;
+
+	// Mesh the tick waits for
+	TWeakObjectPtr<USkeletalMeshComponent> PrerequisiteComponent;
+
+	TArray<FVector> Locations;
+	TArray<FQuat> Rotations;
+};
@@ -0,0 +1,129 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MotionIntensityBatch.h"
+#include "MotionIntensitySubsystem.generated.h"
+
+class UMotionIntensityComponent;
+class UMotionIntensitySubsystem;
+struct FMotionIntensityReplicatedData;
+class FMotionIntensityPhysicsOutput;
+class FMotionIntensityPhysicsCallback;
+class FSingleParticlePhysicsProxy;
+
+USTRUCT()
+struct FMotionIntensitySubsystemTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UMotionIntensitySubsystem* Subsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime,
+	                         ELevelTick TickType,
+	                         ENamedThreads::Type CurrentThread,
+	                         const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template <>
+struct TStructOpsTypeTraits<FMotionIntensitySubsystemTickFunction> : public TStructOpsTypeTraitsBase2<FMotionIntensitySubsystemTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+// Evaluates all Motion Intensity Components of a world in one tick, batched by preset
+UCLASS()
+class MOTIONINTENSITY_API UMotionIntensitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	void RegisterComponent(UMotionIntensityComponent* Component);
+	void UnregisterComponent(UMotionIntensityComponent* Component);
+	void ResetComponent(const UMotionIntensityComponent* Component);
+
+	// Syncs the component's smoothing state with motion data replicated from the server
+	void ApplyReplicatedData(const UMotionIntensityComponent* Component, const FMotionIntensityReplicatedData& ReplicatedData);
+
+	// Updates all registered components
+	void Tick(float DeltaTime);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Components sharing a preset and input kind, and the buffers used to evaluate them
+	struct FComponentGroup
+	{
+		const UMotionIntensityPreset* Preset = nullptr;
+		bool bUseComponentVelocity = false;
+		TArray<UMotionIntensityComponent*> Components;
+		FMotionIntensityBatch Batch;
+		TArray<FVector> Locations;
+		TArray<FQuat> Rotations;
+		TArray<FVector> LinearVelocities;
+		TArray<FVector> AngularVelocities;
+		TArray<FMotionIntensityMotionData> MotionData;
+		TArray<float> MotionIntensities;
+	};
+
+	// Component evaluated on the physics thread and the output its results arrive in.
+	// Body id is 0 while the tracked primitive has no physics state.
+	struct FPhysicsEntry
+	{
+		UMotionIntensityComponent* Component = nullptr;
+		TWeakObjectPtr<UPrimitiveComponent> PrimitiveComponent;
+		uint32 BodyId = 0;
+		TSharedPtr<FMotionIntensityPhysicsOutput, ESPMode::ThreadSafe> Output;
+	};
+
+	void TickGroup(FComponentGroup& Group, float DeltaTime);
+
+	// Moves the batches along with the world when its origin is rebased
+	void OnWorldOriginOffset(UWorld* World, FIntVector SourceOrigin, FIntVector DestinationOrigin);
+
+	// Takes the latest physics step results over
+	void TickPhysicsEntries(float DeltaTime);
+
+	// Fires threshold events of the components updated this frame
+	void BroadcastThresholdEvents();
+
+	// Returns false if the component doesn't track a physics body
+	bool RegisterPhysicsComponent(UMotionIntensityComponent* Component);
+	void UnregisterPhysicsComponent(UMotionIntensityComponent* Component);
+
+	// Starts evaluating the body of the entry on the physics thread
+	void AddPhysicsBody(FPhysicsEntry& Entry, FSingleParticlePhysicsProxy* Proxy);
+
+	// Removes bodies before their proxy is freed and adds them again once their primitive has a new one,
+	// e.g. after a mesh change or a collision change from NoCollision
+	UFUNCTION()
+	void OnPhysicsStateChanged(UPrimitiveComponent* ChangedComponent, EComponentPhysicsStateChange StateChange);
+
+	// Outputs the latest update to the component
+	void UpdateComponent(UMotionIntensityComponent* Component,
+	                     const FMotionIntensityMotionData& MotionData,
+	                     float MotionIntensity,
+	                     float DeltaTime);
+
+	TArray<FComponentGroup> Groups;
+	TArray<FPhysicsEntry> PhysicsEntries;
+
+	// Components whose thresholds changed this frame, events fire after all updates since handlers may unregister components
+	TArray<TWeakObjectPtr<UMotionIntensityComponent>> ThresholdEventComponents;
+
+	// Created with the first physics component, owned by the solver
+	FMotionIntensityPhysicsCallback* PhysicsCallback = nullptr;
+	FMotionIntensitySubsystemTickFunction TickFunction;
+	FDelegateHandle WorldOriginOffsetHandle;
+};
@@ -0,0 +1,73 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "MotionIntensity.h"
+#include "MotionIntensityThreshold.generated.h"
+
+// Value a threshold watches, overall motion intensity or one normalized channel of the motion data
+UENUM(BlueprintType)
+enum class EMotionIntensityChannel : uint8
+{
+	MotionIntensity,
+	LinearVelocity,
+	PositiveLinearAcceleration,
+	NegativeLinearAcceleration,
+	PositiveLinearJerk,
+	NegativeLinearJerk,
+	AngularVelocity,
+	PositiveAngularAcceleration,
+	NegativeAngularAcceleration,
+	PositiveAngularJerk,
+	NegativeAngularJerk
+};
+
+// Turns a channel into an active state with hysteresis, e.g. "intense motion started" and "intense motion ended".
+// Enters once the value stays at or above Enter Threshold for Enter Hold Time, exits once it stays below Exit Threshold
+// for Exit Hold Time. A gap between the thresholds keeps a noisy value from flickering around a single threshold.
+USTRUCT(BlueprintType)
+struct MOTIONINTENSITY_API FMotionIntensityThreshold
+{
+	GENERATED_BODY()
+
+	// Identifies the threshold in events
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Threshold")
+	FName Name;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Threshold")
+	EMotionIntensityChannel Channel = EMotionIntensityChannel::MotionIntensity;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Threshold", meta = (ClampMin = "0.0"))
+	float EnterThreshold = 1.0f;
+
+	// Clamped to Enter Threshold, equal thresholds mean no hysteresis
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Threshold", meta = (ClampMin = "0.0"))
+	float ExitThreshold = 0.5f;
+
+	// Time the value has to stay at or above Enter Threshold before entering, ignores shorter spikes
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Threshold", meta = (ClampMin = "0.0", Units = "s"))
+	float EnterHoldTime = 0.0f;
+
+	// Time the value has to stay below Exit Threshold before exiting, bridges short dips
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Threshold", meta = (ClampMin = "0.0", Units = "s"))
+	float ExitHoldTime = 0.0f;
+
+	// Advances by an update Delta Time seconds after the previous one, returns true if the state changed
+	bool Update(const FMotionIntensityMotionData& MotionData, float MotionIntensity, float DeltaTime);
+
+	// Back to inactive without a transition
+	void Reset();
+
+	bool IsActive() const
+	{
+		return bActive;
+	}
+
+	static float GetChannelValue(EMotionIntensityChannel InChannel, const FMotionIntensityMotionData& MotionData, float MotionIntensity);
+
+private:
+	bool bActive = false;
+
+	// Time the value has been past the threshold of the next transition
+	float PendingTime = 0.0f;
+};
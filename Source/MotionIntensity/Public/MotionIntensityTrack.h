@@ -0,0 +1,77 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "Curves/CurveFloat.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "MotionIntensity.h"
+#include "MotionIntensityTrack.generated.h"
+
+// Streams a sampled transform track through the motion data pipeline, one sample at a time.
+// Used to bake motion intensity offline, e.g. for cinematics and animation assets. Doesn't allocate per sample.
+class MOTIONINTENSITY_API FMotionIntensityTrackEvaluator
+{
+public:
+	FMotionIntensityTrackEvaluator(const FMotionIntensityConfig& InConfig, const FMotionIntensityCoefficients& InCoefficients);
+
+	// True if config and coefficients are valid, invalid evaluators output zeros
+	bool IsValid() const
+	{
+		return bIsValid;
+	}
+
+	// Starts a new track
+	void Reset();
+
+	// Feeds the next sample, time is in seconds and must increase.
+	// The first sample and samples that don't advance time output the previous result.
+	void AddSample(const FTransform& Transform,
+	               double Time,
+	               FMotionIntensityMotionData& OutMotionData,
+	               float& OutMotionIntensity);
+
+	// Evaluates a whole track, times are optional if the track is sampled uniformly at SampleRate.
+	// Outputs must have as many elements as there are transforms, motion data output is optional.
+	bool EvaluateTrack(TArrayView<const FTransform> Transforms,
+	                   TArrayView<const float> Times,
+	                   float SampleRate,
+	                   TArrayView<float> OutMotionIntensities,
+	                   TArrayView<FMotionIntensityMotionData> OutMotionData = TArrayView<FMotionIntensityMotionData>());
+
+private:
+	FMotionIntensityConfig Config;
+	FMotionIntensityCompiledCoefficients Coefficients;
+	FMotionIntensityServiceData ServiceData;
+	FMotionIntensityMotionData LastMotionData;
+	float LastMotionIntensity = 0.0f;
+	double LastTime = 0.0;
+	bool bHasSample = false;
+	bool bIsValid = false;
+};
+
+UCLASS(meta=(BlueprintThreadSafe))
+class UMotionIntensityTrackFunctionLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Bakes overall motion intensity of a transform track into a curve, times are in seconds and must strictly increase,
+	// otherwise nothing is baked and false is returned
+	UFUNCTION(BlueprintCallable)
+	static UPARAM(DisplayName = "Success") bool BakeMotionIntensityCurve(
+		UPARAM(DisplayName = "Transforms") const TArray<FTransform>& Transforms,
+		UPARAM(DisplayName = "Times") const TArray<float>& Times,
+		UPARAM(DisplayName = "Config") const FMotionIntensityConfig& Config,
+		UPARAM(DisplayName = "Coefficients") const FMotionIntensityCoefficients& Coefficients,
+		UPARAM(DisplayName = "Motion Intensity Curve") FRuntimeFloatCurve& OutCurve);
+
+	// Same as above, also outputs motion data for every sample
+	UFUNCTION(BlueprintCallable)
+	static UPARAM(DisplayName = "Success") bool BakeMotionData(
+		UPARAM(DisplayName = "Transforms") const TArray<FTransform>& Transforms,
+		UPARAM(DisplayName = "Times") const TArray<float>& Times,
+		UPARAM(DisplayName = "Config") const FMotionIntensityConfig& Config,
+		UPARAM(DisplayName = "Coefficients") const FMotionIntensityCoefficients& Coefficients,
+		UPARAM(DisplayName = "Motion Intensities") TArray<float>& OutMotionIntensities,
+		UPARAM(DisplayName = "Motion Data") TArray<FMotionIntensityMotionData>& OutMotionData);
+};
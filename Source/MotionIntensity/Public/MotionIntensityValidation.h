@@ -0,0 +1,61 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "MotionIntensity.h"
+
+// Validation done once at the API boundary, everything past it runs unchecked.
+// Errors are counted per category and logged at most once per MotionIntensity.ErrorLogInterval seconds per category,
+// so invalid input from thousands of objects per frame doesn't flood the log. Safe to call from any thread.
+namespace MotionIntensityValidation
+{
+	MOTIONINTENSITY_API void ReportError(EMotionIntensityError Error, const TCHAR* Message);
+
+	MOTIONINTENSITY_API int64 GetErrorCount(EMotionIntensityError Error);
+
+	MOTIONINTENSITY_API void ResetErrorCounts();
+
+	FORCEINLINE bool ValidateDeltaTime(const float DeltaTime)
+	{
+		if (LIKELY(DeltaTime > 0.0f))
+		{
+			return true;
+		}
+
+		ReportError(EMotionIntensityError::InvalidDeltaTime, TEXT("Delta Time should be larger than zero"));
+		return false;
+	}
+
+	FORCEINLINE bool ValidateConfig(const FMotionIntensityConfig& Config)
+	{
+		if (LIKELY(Config.IsValid()))
+		{
+			return true;
+		}
+
+		ReportError(EMotionIntensityError::InvalidConfig, TEXT("MotionIntensityConfig is invalid"));
+		return false;
+	}
+
+	FORCEINLINE bool ValidateCoefficients(const FMotionIntensityCoefficients& Coefficients)
+	{
+		if (LIKELY(Coefficients.IsValid()))
+		{
+			return true;
+		}
+
+		ReportError(EMotionIntensityError::InvalidCoefficients, TEXT("MotionIntensityCoefficients is invalid"));
+		return false;
+	}
+
+	FORCEINLINE bool ValidateCoefficients(const FMotionIntensityCompiledCoefficients& CompiledCoefficients)
+	{
+		if (LIKELY(CompiledCoefficients.IsValid()))
+		{
+			return true;
+		}
+
+		ReportError(EMotionIntensityError::InvalidCoefficients, TEXT("MotionIntensityCompiledCoefficients is invalid"));
+		return false;
+	}
+}
@@ -0,0 +1,96 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "MotionIntensity.h"
+#include "MotionIntensityWindowStats.generated.h"
+
+// Mean, RMS and max of the latest samples of a value, e.g. "peak motion intensity over the last 2 seconds".
+// Kept next to Service Data, one per tracked value. Samples live in a ring buffer allocated once on the first sample,
+// every statistic is updated in O(1) amortized per sample: running sums for mean and RMS, a monotonic deque for max.
+USTRUCT(BlueprintType)
+struct MOTIONINTENSITY_API FMotionIntensityWindowStats
+{
+	GENERATED_BODY()
+
+	// Largest number of samples in the window, changing it empties the window
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Window Stats", meta = (ClampMin = "1"))
+	int32 Capacity = 120;
+
+	// If larger than zero, samples older than this many seconds leave the window even if it isn't full.
+	// Capacity has to cover the duration at the lowest expected frame rate, or the window is shorter.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Window Stats", meta = (ClampMin = "0.0", Units = "s"))
+	float WindowDuration = 0.0f;
+
+	// Adds a sample Delta Time seconds after the previous one, evicting samples that left the window
+	void AddSample(float Value, float DeltaTime);
+
+	// Empties the window, keeps the allocation
+	void Reset();
+
+	// Number of samples in the window
+	int32 Num() const
+	{
+		return Count;
+	}
+
+	// Statistics of the samples in the window, zero if it's empty
+	float GetMean() const;
+	float GetRMS() const;
+	float GetMax() const;
+
+private:
+	void EvictOldest();
+
+	// Ring buffer of samples and the times they were added at
+	TArray<float> Samples;
+	TArray<double> SampleTimes;
+
+	// Slots of samples in decreasing order of value, its front is the max of the window
+	TArray<int32> MaxDeque;
+
+	// Sums are double so evicting a sample cancels its addition
+	double Sum = 0.0;
+	double SumOfSquares = 0.0;
+	double Clock = 0.0;
+
+	int32 Oldest = 0;
+	int32 Count = 0;
+	int32 DequeFront = 0;
+	int32 DequeCount = 0;
+};
+
+UCLASS(meta=(BlueprintThreadSafe))
+class UMotionIntensityWindowStatsFunctionLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Adds a sample, e.g. this frame's motion intensity, Delta Time is the time since the previous sample
+	UFUNCTION(BlueprintCallable)
+	static void AddWindowSample(
+		UPARAM(ref, DisplayName = "Window Stats") FMotionIntensityWindowStats& WindowStats,
+		UPARAM(DisplayName = "Value") float Value,
+		UPARAM(DisplayName = "Delta Time") float DeltaTime);
+
+	// Empties the window
+	UFUNCTION(BlueprintCallable)
+	static void ResetWindowStats(
+		UPARAM(ref, DisplayName = "Window Stats") FMotionIntensityWindowStats& WindowStats);
+
+	// Mean of the samples in the window
+	UFUNCTION(BlueprintPure)
+	static UPARAM(DisplayName = "Mean") float GetWindowMean(
+		UPARAM(DisplayName = "Window Stats") const FMotionIntensityWindowStats& WindowStats);
+
+	// Root mean square of the samples in the window
+	UFUNCTION(BlueprintPure)
+	static UPARAM(DisplayName = "RMS") float GetWindowRMS(
+		UPARAM(DisplayName = "Window Stats") const FMotionIntensityWindowStats& WindowStats);
+
+	// Largest sample in the window
+	UFUNCTION(BlueprintPure)
+	static UPARAM(DisplayName = "Max") float GetWindowMax(
+		UPARAM(DisplayName = "Window Stats") const FMotionIntensityWindowStats& WindowStats);
+};
@@ -0,0 +1,28 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+using UnrealBuildTool;
+
+public class MotionIntensityEditor : ModuleRules
+{
+	public MotionIntensityEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Engine",
+				"AnimGraph",
+				"MotionIntensity"
+			}
+		);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"BlueprintGraph",
+				"UnrealEd"
+			}
+		);
+	}
+}
@@ -0,0 +1,62 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#include "MotionIntensityAnimGraphNode.h"
+#include "Animation/Skeleton.h"
+#include "Kismet2/CompilerResultsLog.h"
+
+#define LOCTEXT_NAMESPACE "MotionIntensityAnimGraphNode"
+
+/* Public methods */
+
+FText UAnimGraphNode_MotionIntensity::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	if (Node.SampleSource == EMotionIntensityAnimSource::ComponentTransform || Node.Bone.BoneName.IsNone()
+		|| TitleType == ENodeTitleType::ListView || TitleType == ENodeTitleType::MenuTitle)
+	{
+		return LOCTEXT("Title", "Motion Intensity");
+	}
+
+	return FText::Format(LOCTEXT("BoneTitle", "Motion Intensity\n{0}"), FText::FromName(Node.Bone.BoneName));
+}
+
+FText UAnimGraphNode_MotionIntensity::GetTooltipText() const
+{
+	return LOCTEXT("Tooltip", "Tracks the motion intensity of a bone or of the mesh, passing the pose through. "
+		"Read the results with the Motion Intensity node functions.\n"
+		"Bones are sampled when the pose is evaluated, after the update, so their results are read one update late. "
+		"The component transform is sampled during the update, as captured when it started.");
+}
+
+FString UAnimGraphNode_MotionIntensity::GetNodeCategory() const
+{
+	return TEXT("Motion Intensity");
+}
+
+FLinearColor UAnimGraphNode_MotionIntensity::GetNodeTitleColor() const
+{
+	return FLinearColor(0.7f, 0.7f, 0.7f);
+}
+
+/* Protected methods */
+
+void UAnimGraphNode_MotionIntensity::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	if (Node.SampleSource != EMotionIntensityAnimSource::Bone || !ForSkeleton)
+	{
+		return;
+	}
+
+	if (Node.Bone.BoneName.IsNone())
+	{
+		MessageLog.Warning(*LOCTEXT("NoBone", "@@ - No bone to track").ToString(), this);
+	}
+	else if (ForSkeleton->GetReferenceSkeleton().FindBoneIndex(Node.Bone.BoneName) == INDEX_NONE)
+	{
+		MessageLog.Warning(*FText::Format(LOCTEXT("MissingBone", "@@ - Bone {0} isn't in the skeleton"),
+		                                  FText::FromName(Node.Bone.BoneName)).ToString(), this);
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,26 @@
+﻿// Copyright (c) 2024 Tyoma Makeev
+
+#pragma once
+
+#include "AnimGraphNode_Base.h"
+#include "MotionIntensityAnimNode.h"
+#include "MotionIntensityAnimGraphNode.generated.h"
+
+// Anim graph node of FAnimNode_MotionIntensity
+UCLASS()
+class MOTIONINTENSITYEDITOR_API UAnimGraphNode_MotionIntensity : public UAnimGraphNode_Base
+{
+	GENERATED_BODY()
+
+public:
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+	virtual FString GetNodeCategory() const override;
+	virtual FLinearColor GetNodeTitleColor() const override;
+
+protected:
+	virtual void ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog) override;
+
+	UPROPERTY(EditAnywhere, Category = "Settings")
+	FAnimNode_MotionIntensity Node;
+};